@@ -0,0 +1,411 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include <ftx_api/ftx_models.h>
+#include <ftx_api/ftx_json_decoder.h>
+#include <ftx_api/ftx_hmac_signer.h>
+#include <ftx_api/ftx_ticker_slot.h>
+#include <ftx_api/ftx_t6.h>
+#include <ftx_api/utils.h>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+#ifndef FTX_BENCH_FIXTURES_DIR
+#define FTX_BENCH_FIXTURES_DIR "fixtures"
+#endif
+
+/// Counted by the replaced global allocation functions, every form of operator new goes through allocate()
+static std::atomic<std::uint64_t> numAllocations = 0;
+
+static void *allocate(std::size_t size, std::size_t alignment) {
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    size = size != 0 ? size : 1;
+
+    if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return std::malloc(size);
+    }
+
+#ifdef _MSC_VER
+    return _aligned_malloc(size, alignment);
+#else
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+static void deallocate(void *ptr, std::size_t alignment) noexcept {
+#ifdef _MSC_VER
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        _aligned_free(ptr);
+        return;
+    }
+#endif
+    std::free(ptr);
+}
+
+static void *allocateOrThrow(std::size_t size, std::size_t alignment) {
+    if (void *ptr = allocate(size, alignment)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+/// GCC sees the malloc/free inside the replacements once they are inlined into new and delete expressions and reports
+/// them as mismatched, the pairing is correct as every operator new has its matching operator delete below
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(std::size_t size) {
+    return allocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new[](std::size_t size) {
+    return allocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *ptr) noexcept {
+    deallocate(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete[](void *ptr) noexcept {
+    deallocate(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    deallocate(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    deallocate(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    deallocate(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    deallocate(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete(void *ptr, std::align_val_t alignment) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void *ptr, std::align_val_t alignment) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t alignment) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t alignment) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *ptr, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void *ptr, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+/// Each benchmark runs at least this long after the batch size is calibrated
+const std::chrono::milliseconds MIN_RUN_TIME{500};
+
+/// Batches shorter than this are doubled while calibrating
+const std::chrono::milliseconds MIN_BATCH_TIME{10};
+
+struct BenchResult {
+    std::string m_name;
+    std::uint64_t m_iterations = 0;
+    double m_nsPerOp = 0.0;
+    double m_allocsPerOp = 0.0;
+};
+
+/// Keep the compiler from dropping a computed value
+template<typename ValueType>
+void doNotOptimize(const ValueType &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const void *volatile sink;
+    sink = &value;
+#endif
+}
+
+template<typename F>
+BenchResult runBenchmark(const std::string &name, F &&f) {
+    std::uint64_t batch = 1;
+
+    for (;;) {
+        const auto start = SteadyClock::now();
+
+        for (std::uint64_t i = 0; i < batch; i++) {
+            f();
+        }
+
+        if (SteadyClock::now() - start >= MIN_BATCH_TIME) {
+            break;
+        }
+
+        batch *= 2;
+    }
+
+    BenchResult result;
+    result.m_name = name;
+
+    const auto allocationsBefore = numAllocations.load(std::memory_order_relaxed);
+    const auto start = SteadyClock::now();
+    auto elapsed = SteadyClock::duration::zero();
+
+    while (elapsed < MIN_RUN_TIME) {
+        for (std::uint64_t i = 0; i < batch; i++) {
+            f();
+        }
+
+        result.m_iterations += batch;
+        elapsed = SteadyClock::now() - start;
+    }
+
+    const auto allocations = numAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+    result.m_nsPerOp = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+                       static_cast<double>(result.m_iterations);
+    result.m_allocsPerOp = static_cast<double>(allocations) / static_cast<double>(result.m_iterations);
+
+    return result;
+}
+
+std::string readFixture(const std::filesystem::path &dir, const std::string &name) {
+    std::ifstream file(dir / name, std::ios::binary);
+
+    if (!file) {
+        throw std::runtime_error("Cannot open fixture: " + (dir / name).string());
+    }
+
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    while (!content.empty() && (content.back() == '\n' || content.back() == '\r')) {
+        content.pop_back();
+    }
+
+    return content;
+}
+
+ftx::Order makeOrder() {
+    ftx::Order order;
+    order.m_market = "BTC-PERP";
+    order.m_side = ftx::Side::buy;
+    order.m_type = ftx::OrderType::limit;
+    order.m_price = 40313.0;
+    order.m_size = 0.0012;
+    order.m_clientId = "1650011222";
+    return order;
+}
+
+void printUsage() {
+    std::printf("Usage: ftx_bench [--fixtures <dir>] [--json <file>] [--filter <substring>]\n");
+}
+}
+
+int main(int argc, char *argv[]) {
+    std::filesystem::path fixturesDir = FTX_BENCH_FIXTURES_DIR;
+    std::string jsonPath;
+    std::string filter;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+
+        if (arg == "--fixtures" && i + 1 < argc) {
+            fixturesDir = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::vector<BenchResult> results;
+
+    const auto bench = [&](const std::string &name, auto &&f) {
+        if (filter.empty() || name.find(filter) != std::string::npos) {
+            results.push_back(runBenchmark(name, f));
+            const auto &result = results.back();
+            std::printf("%-44s %14.1f ns/op %10.2f allocs/op %12llu iterations\n", result.m_name.c_str(),
+                        result.m_nsPerOp, result.m_allocsPerOp,
+                        static_cast<unsigned long long>(result.m_iterations));
+        }
+    };
+
+    try {
+        for (const std::string channel: {"ticker", "orders", "fills"}) {
+            const auto frame = readFixture(fixturesDir, channel + ".json");
+
+            bench("Event::fromJson/" + channel, [&] {
+                ftx::Event event;
+                event.fromJson(nlohmann::json::parse(frame));
+                doNotOptimize(event);
+            });
+
+            bench("decodeEvent/" + channel, [&] {
+                ftx::Event event;
+                doNotOptimize(ftx::decodeEvent(frame, event));
+                doNotOptimize(event);
+            });
+        }
+
+        const auto candlesResponse = readFixture(fixturesDir, "candles_1500.json");
+
+        bench("Candles::fromJson/1500", [&] {
+            ftx::Candles candles;
+            candles.fromJson(nlohmann::json::parse(candlesResponse).at("result"));
+            doNotOptimize(candles);
+        });
+
+        bench("decodeResponse<Candles>/1500", [&] {
+            ftx::Candles candles;
+            bool success;
+            std::string error;
+            doNotOptimize(ftx::decodeResponse(candlesResponse, success, error, candles));
+            doNotOptimize(candles);
+        });
+
+        const auto order = makeOrder();
+
+        bench("Order::toJson().dump()", [&] {
+            doNotOptimize(order.toJson().dump());
+        });
+
+        /// Same parts as signed by HTTPSession for an order placement
+        const ftx::HMACSigner signer("Y2QTHI23f23f23jfjas23f23To0RfUwX3H42fvN-");
+        const auto orderPayload = order.toJson().dump();
+
+        bench("HMACSigner::sign/order", [&] {
+            doNotOptimize(signer.sign({"1650011222114", "POST", "/api/orders", orderPayload}));
+        });
+
+        const std::string timeString = "2022-04-15T08:27:02.127371+00:00";
+        const std::string timeFormat = "%Y-%m-%dT%H:%M:%S";
+
+        bench("getTimeStampFromString", [&] {
+            doNotOptimize(ftx::getTimeStampFromString(timeString, timeFormat));
+        });
+
+        {
+            /// The stream IO thread is replaced by a writer storing ticks as fast as possible into the same slot
+            ftx::TickerSlot slot;
+            std::atomic<bool> stop = false;
+            ftx::TickerData tick;
+            tick.m_bid = 40312.0;
+            tick.m_ask = 40313.0;
+            slot.store(tick);
+
+            std::thread writer([&] {
+                ftx::TickerData data = tick;
+
+                while (!stop.load(std::memory_order_relaxed)) {
+                    data.m_time++;
+                    slot.store(data);
+                }
+            });
+
+            bench("readTickerData/concurrent_writer", [&] {
+                ftx::TickerData data;
+                doNotOptimize(slot.load(data));
+                doNotOptimize(data);
+            });
+
+            stop = true;
+            writer.join();
+        }
+
+        ftx::Candles candles;
+        candles.fromJson(nlohmann::json::parse(candlesResponse).at("result"));
+        std::vector<ftx::T6Record> records(candles.m_candles.size());
+
+        bench("convertCandlesToT6/1500", [&] {
+            doNotOptimize(ftx::convertCandlesToT6(candles.m_candles, records.size(), records.data()));
+            doNotOptimize(records);
+        });
+    }
+    catch (const std::exception &e) {
+        std::fprintf(stderr, "Benchmark failed: %s\n", e.what());
+        return 1;
+    }
+
+    if (!jsonPath.empty()) {
+        nlohmann::json json = nlohmann::json::array();
+
+        for (const auto &result: results) {
+            json.push_back({{"name", result.m_name},
+                            {"iterations", result.m_iterations},
+                            {"ns_per_op", result.m_nsPerOp},
+                            {"allocs_per_op", result.m_allocsPerOp}});
+        }
+
+        std::ofstream file(jsonPath);
+        file << json.dump(4) << std::endl;
+    }
+
+    return 0;
+}
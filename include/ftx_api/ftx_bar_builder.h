@@ -0,0 +1,78 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_BAR_BUILDER_H
+#define FTX_BAR_BUILDER_H
+
+#include <ftx_api/ftx_models.h>
+#include <array>
+#include <vector>
+
+namespace ftx {
+
+/**
+ * Rolling OHLCV bars of a single market aggregated from its trades at all fixed FTX candle resolutions (15 s up to
+ * one day). Each resolution keeps its most recent bars in a bounded ring buffer, intervals without trades get flat
+ * bars at the previous close. Volume is in the quote currency as in FTX candles. Not thread-safe.
+ */
+class BarBuilder {
+
+public:
+
+    static constexpr std::array<std::int32_t, 7> RESOLUTIONS = {15, 60, 300, 900, 3600, 14400, 86400};
+
+    /// Capacity of the ring buffer of every resolution
+    static constexpr std::size_t MAX_BARS = 1500;
+
+private:
+
+    struct Series {
+        std::vector<Candle> m_bars;
+
+        /// Index of the oldest bar once the buffer is full
+        std::size_t m_head = 0;
+
+        /// Start of the bar open when the first trade was received, it misses earlier trades
+        std::int64_t m_partialStart = -1;
+
+        [[nodiscard]] const Candle &at(std::size_t i) const;
+
+        Candle &at(std::size_t i);
+
+        void push(const Candle &bar);
+    };
+
+    std::array<Series, RESOLUTIONS.size()> m_series;
+
+public:
+
+    /**
+     * Aggregate a trade into the bars of all resolutions
+     * @param trade
+     */
+    void add(const Trade &trade);
+
+    /**
+     * Drop all bars, must be called when trades may have been missed (e.g. after a disconnect)
+     */
+    void clear();
+
+    /**
+     * Read bars starting in [from, to], the partial first bar is never returned. When no trades came since the last
+     * bar, flat bars are appended up to the bar containing min(to, now).
+     * @param resolutionInSecs one of RESOLUTIONS, otherwise nothing is returned
+     * @param from seconds from epoch
+     * @param to seconds from epoch
+     * @return bars ordered from the oldest, empty if the range is not covered
+     */
+    [[nodiscard]] std::vector<Candle> read(std::int32_t resolutionInSecs, std::int64_t from, std::int64_t to) const;
+};
+}
+
+#endif //FTX_BAR_BUILDER_H
@@ -0,0 +1,67 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_CANDLE_STORE_H
+#define FTX_CANDLE_STORE_H
+
+#include <ftx_api/ftx_models.h>
+#include <optional>
+#include <string>
+#include <spimpl.h>
+
+namespace ftx {
+
+/**
+ * Persistent per-market, per-resolution candle store. Each series is kept in its own binary append-only file made
+ * of a fixed header followed by fixed-size little-endian records, so the file can be memory-mapped or read in a
+ * single bulk read. The store is expected to hold a contiguous range of candles, callers extend it only by
+ * the missing head or tail range.
+ */
+class CandleStore {
+
+    struct P;
+    spimpl::unique_impl_ptr<P> m_p{};
+
+public:
+
+    /**
+     * @param directory directory for the store files, created if it does not exist
+     */
+    explicit CandleStore(const std::string &directory);
+
+    /**
+     * Get start times of the first and the last stored candles
+     * @param marketName market name e.g. BTC-PERP
+     * @param resolutionInSecs
+     * @return pair of timestamps in s or nothing if no candle is stored
+     */
+    [[nodiscard]] std::optional<std::pair<std::int64_t, std::int64_t>>
+    range(const std::string &marketName, std::int32_t resolutionInSecs) const;
+
+    /**
+     * Read stored candles
+     * @param marketName market name e.g. BTC-PERP
+     * @param resolutionInSecs
+     * @param from timestamp in s
+     * @param to timestamp in s
+     * @return array of Candle structures with start time in [from, to] sorted from oldest to newest
+     */
+    [[nodiscard]] std::vector<Candle>
+    read(const std::string &marketName, std::int32_t resolutionInSecs, std::int64_t from, std::int64_t to) const;
+
+    /**
+     * Append candles to the store, candles already stored are skipped
+     * @param marketName market name e.g. BTC-PERP
+     * @param resolutionInSecs
+     * @param candles
+     */
+    void append(const std::string &marketName, std::int32_t resolutionInSecs, const std::vector<Candle> &candles);
+};
+}
+#endif //FTX_CANDLE_STORE_H
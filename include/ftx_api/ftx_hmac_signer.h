@@ -0,0 +1,47 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_HMAC_SIGNER_H
+#define FTX_HMAC_SIGNER_H
+
+#include <array>
+#include <initializer_list>
+#include <string_view>
+#include <spimpl.h>
+
+namespace ftx {
+
+/**
+ * HMAC-SHA256 signer keyed once per API secret. The inner and outer key pads are hashed at construction, signing
+ * only continues copies of both digest states.
+ */
+class HMACSigner {
+
+    struct P;
+    spimpl::unique_impl_ptr<P> m_p{};
+
+public:
+
+    /// Length of the hex encoded signature
+    static constexpr std::size_t SIGNATURE_LENGTH = 64;
+
+    using Signature = std::array<char, SIGNATURE_LENGTH>;
+
+    explicit HMACSigner(std::string_view secret);
+
+    /**
+     * Sign the concatenation of the parts without joining them, can be called from multiple threads
+     * @param parts e.g. timestamp, method, path and body
+     * @return Lower case hex encoded signature
+     */
+    [[nodiscard]] Signature sign(std::initializer_list<std::string_view> parts) const;
+};
+}
+
+#endif //FTX_HMAC_SIGNER_H
@@ -30,6 +30,18 @@ public:
     HTTPSession(const std::string &uri, const std::string &apiKey, const std::string &apiSecret,
                 const std::string &subAccountName);
 
+    /**
+     * Set maximum number of simultaneously opened keep-alive connections to the host, default is 4
+     * @param maxConnections
+     */
+    void setMaxConnections(std::size_t maxConnections);
+
+    /**
+     * Get maximum number of simultaneously opened keep-alive connections to the host
+     * @return
+     */
+    [[nodiscard]] std::size_t maxConnections() const;
+
     http::response<http::string_body> methodGet(const std::string &target);
 
     http::response<http::string_body> methodPost(const std::string &target, const std::string &payload);
@@ -0,0 +1,71 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_JSON_DECODER_H
+#define FTX_JSON_DECODER_H
+
+#include <ftx_api/ftx_models.h>
+#include <ftx_api/ftx_json_reader.h>
+#include <string_view>
+#include <type_traits>
+
+namespace ftx {
+
+/**
+ * Models decodable by the streaming decoder, others are decoded through the nlohmann::json DOM
+ */
+template<typename ValueType>
+inline constexpr bool isStreamDecodable =
+        HasJsonFields<ValueType> || std::is_same_v<ValueType, Positions> || std::is_same_v<ValueType, Candles> ||
+        std::is_same_v<ValueType, Fills> || std::is_same_v<ValueType, Orders> || std::is_same_v<ValueType, Markets>;
+
+/**
+ * Decode a model directly from a JSON buffer
+ * @tparam ValueType one of the isStreamDecodable types
+ * @param buffer
+ * @param value
+ * @return False if the buffer cannot be decoded, the caller should fall back to the DOM
+ */
+template<typename ValueType>
+bool decodeJson(std::string_view buffer, ValueType &value);
+
+/**
+ * Decode a REST response envelope {"success": ..., "result": ..., "error": ...}
+ * @tparam ValueType one of the isStreamDecodable types
+ * @param buffer response body
+ * @param success
+ * @param error error message if not successful
+ * @param value decoded result if successful
+ * @return False if the buffer cannot be decoded, the caller should fall back to the DOM
+ */
+template<typename ValueType>
+bool decodeResponse(std::string_view buffer, bool &success, std::string &error, ValueType &value);
+
+/**
+ * Decode a WebSocket event, ticker, orderbook, trades, markets, orders and fills data are supported
+ * @param buffer
+ * @param event
+ * @return False if the event cannot be decoded (e.g. unsupported channel or "data" preceding "channel"), the caller
+ * should fall back to the DOM
+ */
+bool decodeEvent(std::string_view buffer, Event &event);
+
+/**
+ * Read the top level "type", "channel" and "market" attributes of a WebSocket frame, other values are skipped
+ * @param buffer
+ * @param type empty if missing
+ * @param channel empty if missing
+ * @param market empty if missing
+ * @return False on a syntax error
+ */
+bool decodeEventHeader(std::string_view buffer, std::string_view &type, std::string_view &channel,
+                       std::string_view &market);
+}
+
+#endif //FTX_JSON_DECODER_H
@@ -0,0 +1,336 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_JSON_FIELDS_H
+#define FTX_JSON_FIELDS_H
+
+#include <ftx_api/ftx_json_reader.h>
+#include <ftx_api/utils.h>
+#include <nlohmann/json.hpp>
+#include <array>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace ftx {
+
+/**
+ * Compile-time descriptor of a single JSON attribute mapped to a model member
+ * @tparam Codec void for the default encoding of the member type, otherwise a type with static read, fromJson and
+ * toJson functions (see TimestampCodec)
+ */
+template<typename Class, typename Member, typename Codec = void>
+struct JsonField {
+    using CodecType = Codec;
+
+    std::string_view m_name;
+    Member Class::*m_member;
+};
+
+template<typename Class, typename Member>
+constexpr JsonField<Class, Member> jsonField(std::string_view name, Member Class::*member) {
+    return {name, member};
+}
+
+template<typename Codec, typename Class, typename Member>
+constexpr JsonField<Class, Member, Codec> jsonField(std::string_view name, Member Class::*member) {
+    return {name, member};
+}
+
+/**
+ * ISO-8601 date-time string stored as microseconds from epoch, e.g. "2019-03-05T09:56:55.728933+00:00"
+ */
+struct TimestampCodec {
+    /// Null and unparsable strings leave the value untouched
+    static bool read(JsonReader &reader, std::int64_t &value) {
+        std::string_view timeString;
+
+        if (reader.readNull()) {
+            return true;
+        }
+
+        if (!reader.readStringView(timeString)) {
+            return false;
+        }
+
+        parseTimestamp(timeString, value);
+        return true;
+    }
+
+    static void fromJson(const nlohmann::json &json, std::int64_t &value) {
+        if (json.is_string()) {
+            parseTimestamp(json.get_ref<const std::string &>(), value);
+        }
+    }
+
+    static nlohmann::json toJson(std::int64_t value) {
+        return getStringFromMicroseconds(value);
+    }
+};
+
+/**
+ * Field table of a model, specialize with a static constexpr tuple of JsonField named fields:
+ *
+ * template<> struct JsonFields<TickerData> {
+ *     static constexpr auto fields = std::make_tuple(jsonField("bid", &TickerData::m_bid), ...);
+ * };
+ *
+ * Decoding (streaming and DOM) and encoding are generated from the table.
+ */
+template<typename ValueType>
+struct JsonFields;
+
+template<typename ValueType>
+concept HasJsonFields = requires { JsonFields<ValueType>::fields; };
+
+/// Enum declared by BETTER_ENUM
+template<typename ValueType>
+concept BetterEnum = requires { typename ValueType::_enumerated; };
+
+template<typename ValueType>
+struct IsVector : std::false_type {
+};
+
+template<typename ValueType>
+struct IsVector<std::vector<ValueType>> : std::true_type {
+};
+
+template<typename ValueType>
+bool readJsonValue(JsonReader &reader, ValueType &value);
+
+template<typename ValueType>
+void fromJsonValue(const nlohmann::json &json, ValueType &value);
+
+template<typename ValueType>
+nlohmann::json toJsonValue(const ValueType &value);
+
+/**
+ * Per model dispatch tables generated from JsonFields
+ */
+template<typename ValueType>
+struct JsonFieldTable {
+    using FieldsType = std::remove_cvref_t<decltype(JsonFields<ValueType>::fields)>;
+    static constexpr std::size_t SIZE = std::tuple_size_v<FieldsType>;
+
+    using StreamReader = bool (*)(JsonReader &, ValueType &);
+    using DomReader = void (*)(const nlohmann::json &, ValueType &);
+
+    template<std::size_t I>
+    using Codec = typename std::tuple_element_t<I, FieldsType>::CodecType;
+
+    template<std::size_t I>
+    static bool readField(JsonReader &reader, ValueType &value) {
+        auto &member = value.*(std::get<I>(JsonFields<ValueType>::fields).m_member);
+
+        if constexpr (std::is_void_v<Codec<I>>) {
+            return readJsonValue(reader, member);
+        } else {
+            return Codec<I>::read(reader, member);
+        }
+    }
+
+    template<std::size_t I>
+    static void fromJsonField(const nlohmann::json &json, ValueType &value) {
+        auto &member = value.*(std::get<I>(JsonFields<ValueType>::fields).m_member);
+
+        if constexpr (std::is_void_v<Codec<I>>) {
+            fromJsonValue(json, member);
+        } else {
+            Codec<I>::fromJson(json, member);
+        }
+    }
+
+    template<std::size_t... I>
+    static constexpr std::array<std::string_view, SIZE> makeNames(std::index_sequence<I...>) {
+        return {std::get<I>(JsonFields<ValueType>::fields).m_name...};
+    }
+
+    template<std::size_t... I>
+    static constexpr std::array<StreamReader, SIZE> makeStreamReaders(std::index_sequence<I...>) {
+        return {&readField<I>...};
+    }
+
+    template<std::size_t... I>
+    static constexpr std::array<DomReader, SIZE> makeDomReaders(std::index_sequence<I...>) {
+        return {&fromJsonField<I>...};
+    }
+
+    static constexpr PerfectHash<SIZE> hash{makeNames(std::make_index_sequence<SIZE>{})};
+    static constexpr std::array<StreamReader, SIZE> streamReaders = makeStreamReaders(
+            std::make_index_sequence<SIZE>{});
+    static constexpr std::array<DomReader, SIZE> domReaders = makeDomReaders(std::make_index_sequence<SIZE>{});
+};
+
+/**
+ * Read a BETTER_ENUM value, null and unknown names leave the value untouched
+ * @return False if the value is not a string
+ */
+template<typename ValueType>
+bool readJsonEnum(JsonReader &reader, ValueType &value) {
+    std::string_view name;
+
+    if (!reader.readStringView(name)) {
+        return false;
+    }
+
+    if (const auto result = enumFromString<ValueType>(name)) {
+        value = *result;
+    }
+
+    return true;
+}
+
+/**
+ * Decode all known attributes of an object into a model, unknown attributes are skipped
+ */
+template<typename ValueType>
+bool readJsonFields(JsonReader &reader, ValueType &value) {
+    using Table = JsonFieldTable<ValueType>;
+    std::string_view key;
+
+    if (!reader.beginObject()) {
+        return false;
+    }
+
+    while (reader.nextKey(key)) {
+        const auto index = Table::hash.find(key);
+
+        if (!(index < 0 ? reader.skipValue() : Table::streamReaders[index](reader, value))) {
+            return false;
+        }
+    }
+
+    return !reader.failed();
+}
+
+template<typename ValueType>
+bool readJsonValue(JsonReader &reader, ValueType &value) {
+    if constexpr (std::is_same_v<ValueType, double>) {
+        return reader.readDouble(value);
+    } else if constexpr (std::is_same_v<ValueType, bool>) {
+        return reader.readBool(value);
+    } else if constexpr (std::is_same_v<ValueType, std::string>) {
+        return reader.readString(value);
+    } else if constexpr (std::is_integral_v<ValueType>) {
+        std::int64_t number = value;
+
+        if (!reader.readInt64(number)) {
+            return false;
+        }
+
+        value = static_cast<ValueType>(number);
+        return true;
+    } else if constexpr (BetterEnum<ValueType>) {
+        return readJsonEnum(reader, value);
+    } else if constexpr (IsVector<ValueType>::value) {
+        value.clear();
+
+        if (reader.readNull()) {
+            return true;
+        }
+
+        if (!reader.beginArray()) {
+            return false;
+        }
+
+        while (reader.nextElement()) {
+            if (!readJsonValue(reader, value.emplace_back())) {
+                return false;
+            }
+        }
+
+        return !reader.failed();
+    } else {
+        static_assert(HasJsonFields<ValueType>, "Unsupported JSON field type");
+        return reader.readNull() || readJsonFields(reader, value);
+    }
+}
+
+/**
+ * Decode all known attributes of a DOM object into a model in one pass over the object
+ */
+template<typename ValueType>
+void fromJsonFields(const nlohmann::json &json, ValueType &value) {
+    using Table = JsonFieldTable<ValueType>;
+
+    if (!json.is_object()) {
+        return;
+    }
+
+    for (auto it = json.begin(); it != json.end(); ++it) {
+        if (const auto index = Table::hash.find(it.key()); index >= 0) {
+            Table::domReaders[index](it.value(), value);
+        }
+    }
+}
+
+template<typename ValueType>
+void fromJsonValue(const nlohmann::json &json, ValueType &value) {
+    if (json.is_null()) {
+        return;
+    }
+
+    if constexpr (BetterEnum<ValueType>) {
+        if (const auto result = enumFromString<ValueType>(json.get_ref<const std::string &>())) {
+            value = *result;
+        }
+    } else if constexpr (IsVector<ValueType>::value) {
+        value.clear();
+
+        for (const auto &el: json) {
+            fromJsonValue(el, value.emplace_back());
+        }
+    } else if constexpr (HasJsonFields<ValueType>) {
+        fromJsonFields(json, value);
+    } else {
+        value = json.get<ValueType>();
+    }
+}
+
+/**
+ * Encode all fields of a model, the exact inverse of fromJsonFields
+ */
+template<typename ValueType>
+nlohmann::json toJsonFields(const ValueType &value) {
+    nlohmann::json json = nlohmann::json::object();
+
+    const auto encode = [&]<typename Field>(const Field &field) {
+        if constexpr (std::is_void_v<typename Field::CodecType>) {
+            json[std::string(field.m_name)] = toJsonValue(value.*(field.m_member));
+        } else {
+            json[std::string(field.m_name)] = Field::CodecType::toJson(value.*(field.m_member));
+        }
+    };
+
+    std::apply([&](const auto &... field) { (encode(field), ...); }, JsonFields<ValueType>::fields);
+
+    return json;
+}
+
+template<typename ValueType>
+nlohmann::json toJsonValue(const ValueType &value) {
+    if constexpr (BetterEnum<ValueType>) {
+        return value._to_string();
+    } else if constexpr (IsVector<ValueType>::value) {
+        nlohmann::json json = nlohmann::json::array();
+
+        for (const auto &el: value) {
+            json.push_back(toJsonValue(el));
+        }
+
+        return json;
+    } else if constexpr (HasJsonFields<ValueType>) {
+        return toJsonFields(value);
+    } else {
+        return value;
+    }
+}
+}
+
+#endif //FTX_JSON_FIELDS_H
@@ -0,0 +1,111 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_JSON_READER_H
+#define FTX_JSON_READER_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace ftx {
+
+/**
+ * Forward-only on-demand JSON reader over a contiguous buffer. Values are read directly into the target types,
+ * numbers are parsed by std::from_chars and unwanted values are skipped without being materialized. Any syntax
+ * error puts the reader into a failed state, all subsequent calls then return false.
+ */
+class JsonReader {
+
+    const char *m_pos;
+    const char *m_end;
+    bool m_failed = false;
+
+    void skipWhitespace();
+
+    bool fail();
+
+    bool consume(char c);
+
+    bool readRawString(std::string_view &value);
+
+    bool readNumberToken(std::string_view &value);
+
+public:
+
+    explicit JsonReader(std::string_view buffer);
+
+    [[nodiscard]] bool failed() const { return m_failed; }
+
+    /**
+     * Consume the opening brace of an object
+     * @return False if the next value is not an object
+     */
+    bool beginObject();
+
+    /**
+     * Read the next key of the current object, consumes the separating comma and colon
+     * @param key Raw key, escape sequences are not decoded (FTX keys do not contain any)
+     * @return False at the end of the object or on error
+     */
+    bool nextKey(std::string_view &key);
+
+    /**
+     * Consume the opening bracket of an array
+     * @return False if the next value is not an array
+     */
+    bool beginArray();
+
+    /**
+     * Move to the next element of the current array, consumes the separating comma
+     * @return False at the end of the array or on error
+     */
+    bool nextElement();
+
+    /**
+     * Consume null if it is the next value
+     * @return True if null was consumed
+     */
+    bool readNull();
+
+    /**
+     * Read a number, a numeric string (e.g. "1.5") is accepted too, null leaves the value untouched
+     */
+    bool readDouble(double &value);
+
+    /**
+     * Read a number and keep its text exactly as written, the view points into the buffer
+     */
+    bool readNumber(double &value, std::string_view &text);
+
+    /**
+     * Read an integer, a fractional number is truncated, null leaves the value untouched
+     */
+    bool readInt64(std::int64_t &value);
+
+    bool readBool(bool &value);
+
+    /**
+     * Read a string and decode escape sequences, null leaves the value untouched
+     */
+    bool readString(std::string &value);
+
+    /**
+     * Read a string without decoding escape sequences, the view points into the buffer
+     */
+    bool readStringView(std::string_view &value);
+
+    /**
+     * Skip the next value including all nested objects and arrays
+     */
+    bool skipValue();
+};
+}
+
+#endif //FTX_JSON_READER_H
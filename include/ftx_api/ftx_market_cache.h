@@ -0,0 +1,56 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_MARKET_CACHE_H
+#define FTX_MARKET_CACHE_H
+
+#include <ftx_api/ftx_models.h>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ftx {
+
+/**
+ * Thread-safe in-memory cache of market metadata (increments, minimal sizes, market type...) filled by the bulk
+ * markets request and kept current by the markets channel. Prices of the cached markets are not updated.
+ */
+class MarketCache {
+
+    mutable std::shared_mutex m_locker;
+    std::unordered_map<std::string, Market> m_markets;
+
+public:
+
+    /**
+     * Replace the whole cache
+     * @param markets
+     */
+    void load(const std::vector<Market> &markets);
+
+    /**
+     * Apply a partial or an update received from the markets channel, only the attributes sent by the channel are
+     * merged into known markets
+     * @param data
+     */
+    void update(const MarketsData &data);
+
+    /**
+     * @param name market name e.g. BTC-PERP
+     * @return Market if cached
+     */
+    [[nodiscard]] std::optional<Market> find(const std::string &name) const;
+
+    [[nodiscard]] std::size_t size() const;
+};
+}
+
+#endif //FTX_MARKET_CACHE_H
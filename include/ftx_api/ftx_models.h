@@ -12,7 +12,10 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 
 #include <nlohmann/json.hpp>
 #include <ftx_api/i_json.h>
+#include <ftx_api/ftx_json_fields.h>
 #include <enum.h>
+#include <algorithm>
+#include <array>
 #include <variant>
 
 namespace ftx {
@@ -108,6 +111,32 @@ struct Position : public IJson {
     void fromJson(const nlohmann::json &json) override;
 };
 
+template<>
+struct JsonFields<Position> {
+    static constexpr auto fields = std::make_tuple(
+            jsonField("cost", &Position::m_cost),
+            jsonField("entryPrice", &Position::m_entryPrice),
+            jsonField("future", &Position::m_future),
+            jsonField("initialMarginRequirement", &Position::m_initialMarginRequirement),
+            jsonField("longOrderSize", &Position::m_longOrderSize),
+            jsonField("maintenanceMarginRequirement", &Position::m_maintenanceMarginRequirement),
+            jsonField("netSize", &Position::m_netSize),
+            jsonField("openSize", &Position::m_openSize),
+            jsonField("realizedPnl", &Position::m_realizedPnl),
+            jsonField("shortOrderSize", &Position::m_shortOrderSize),
+            jsonField("side", &Position::m_side),
+            jsonField("size", &Position::m_size),
+            jsonField("unrealizedPnl", &Position::m_unrealizedPnl),
+            jsonField("cumulativeBuySize", &Position::m_cumulativeBuySize),
+            jsonField("cumulativeSellSize", &Position::m_cumulativeSellSize),
+            jsonField("estimatedLiquidationPrice", &Position::m_estimatedLiquidationPrice),
+            jsonField("recentAverageOpenPrice", &Position::m_recentAverageOpenPrice),
+            jsonField("recentBreakEvenPrice", &Position::m_recentBreakEvenPrice),
+            jsonField("recentPnl", &Position::m_recentPnl),
+            jsonField("collateralUsed", &Position::m_collateralUsed)
+    );
+};
+
 struct Positions : public IJson {
     std::vector<Position> m_positions;
 
@@ -139,6 +168,27 @@ struct Account : public IJson {
     void fromJson(const nlohmann::json &json) override;
 };
 
+template<>
+struct JsonFields<Account> {
+    static constexpr auto fields = std::make_tuple(
+            jsonField("backstopProvider", &Account::m_backstopProvider),
+            jsonField("collateral", &Account::m_collateral),
+            jsonField("freeCollateral", &Account::m_freeCollateral),
+            jsonField("initialMarginRequirement", &Account::m_initialMarginRequirement),
+            jsonField("leverage", &Account::m_leverage),
+            jsonField("liquidating", &Account::m_liquidating),
+            jsonField("maintenanceMarginRequirement", &Account::m_maintenanceMarginRequirement),
+            jsonField("makerFee", &Account::m_makerFee),
+            jsonField("marginFraction", &Account::m_marginFraction),
+            jsonField("openMarginFraction", &Account::m_openMarginFraction),
+            jsonField("takerFee", &Account::m_takerFee),
+            jsonField("totalAccountValue", &Account::m_totalAccountValue),
+            jsonField("totalPositionSize", &Account::m_totalPositionSize),
+            jsonField("username", &Account::m_userName),
+            jsonField("positions", &Account::m_positions)
+    );
+};
+
 struct Order : public IJson {
 
     std::string m_createdAt;
@@ -165,6 +215,30 @@ struct Order : public IJson {
     void fromJson(const nlohmann::json &json) override;
 };
 
+template<>
+struct JsonFields<Order> {
+    static constexpr auto fields = std::make_tuple(
+            jsonField("createdAt", &Order::m_createdAt),
+            jsonField("filledSize", &Order::m_filledSize),
+            jsonField("future", &Order::m_future),
+            jsonField("id", &Order::m_id),
+            jsonField("market", &Order::m_market),
+            jsonField("price", &Order::m_price),
+            jsonField("avgFillPrice", &Order::m_avgFillPrice),
+            jsonField("remainingSize", &Order::m_remainingSize),
+            jsonField("side", &Order::m_side),
+            jsonField("size", &Order::m_size),
+            jsonField("status", &Order::m_status),
+            jsonField("type", &Order::m_type),
+            jsonField("reduceOnly", &Order::m_reduceOnly),
+            jsonField("ioc", &Order::m_ioc),
+            jsonField("postOnly", &Order::m_postOnly),
+            jsonField("clientId", &Order::m_clientId),
+            jsonField("trailValue", &Order::m_trailValue),
+            jsonField("triggerPrice", &Order::m_triggerPrice)
+    );
+};
+
 struct Market : public IJson {
 
     std::string m_name;
@@ -194,6 +268,33 @@ struct Market : public IJson {
     void fromJson(const nlohmann::json &json) override;
 };
 
+template<>
+struct JsonFields<Market> {
+    static constexpr auto fields = std::make_tuple(
+            jsonField("name", &Market::m_name),
+            jsonField("baseCurrency", &Market::m_baseCurrency),
+            jsonField("quoteCurrency", &Market::m_quoteCurrency),
+            jsonField("quoteVolume24h", &Market::m_quoteVolume24h),
+            jsonField("change1h", &Market::m_change1h),
+            jsonField("change24h", &Market::m_change24h),
+            jsonField("changeBod", &Market::m_changeBod),
+            jsonField("highLeverageFeeExempt", &Market::m_highLeverageFeeExempt),
+            jsonField("minProvideSize", &Market::m_minProvideSize),
+            jsonField("type", &Market::m_type),
+            jsonField("underlying", &Market::m_underlying),
+            jsonField("enabled", &Market::m_enabled),
+            jsonField("ask", &Market::m_ask),
+            jsonField("bid", &Market::m_bid),
+            jsonField("last", &Market::m_last),
+            jsonField("postOnly", &Market::m_postOnly),
+            jsonField("price", &Market::m_price),
+            jsonField("priceIncrement", &Market::m_priceIncrement),
+            jsonField("sizeIncrement", &Market::m_sizeIncrement),
+            jsonField("restricted", &Market::m_restricted),
+            jsonField("volumeUsd24h", &Market::m_volumeUsd24h)
+    );
+};
+
 struct Markets : public IJson {
     std::vector<Market> m_markets;
 
@@ -204,7 +305,8 @@ struct Markets : public IJson {
 
 struct Candle : public IJson {
 
-    std::string m_startTime;
+    /// Microseconds from epoch
+    std::int64_t m_startTime = 0;
     double m_open = 0.0;
     double m_high = 0.0;
     double m_low = 0.0;
@@ -216,6 +318,18 @@ struct Candle : public IJson {
     void fromJson(const nlohmann::json &json) override;
 };
 
+template<>
+struct JsonFields<Candle> {
+    static constexpr auto fields = std::make_tuple(
+            jsonField<TimestampCodec>("startTime", &Candle::m_startTime),
+            jsonField("open", &Candle::m_open),
+            jsonField("high", &Candle::m_high),
+            jsonField("low", &Candle::m_low),
+            jsonField("close", &Candle::m_close),
+            jsonField("volume", &Candle::m_volume)
+    );
+};
+
 struct Candles : public IJson {
     std::vector<Candle> m_candles;
 
@@ -234,6 +348,15 @@ struct ChannelSubscriptionRequest : public IJson {
     void fromJson(const nlohmann::json &json) override;
 };
 
+template<>
+struct JsonFields<ChannelSubscriptionRequest> {
+    static constexpr auto fields = std::make_tuple(
+            jsonField("op", &ChannelSubscriptionRequest::m_op),
+            jsonField("channel", &ChannelSubscriptionRequest::m_channel),
+            jsonField("market", &ChannelSubscriptionRequest::m_market)
+    );
+};
+
 struct ChannelSubscriptionResponse : public IJson {
     OperationResponse m_type = OperationResponse::error;
     Channel m_channel = Channel::ticker;
@@ -246,6 +369,17 @@ struct ChannelSubscriptionResponse : public IJson {
     void fromJson(const nlohmann::json &json) override;
 };
 
+template<>
+struct JsonFields<ChannelSubscriptionResponse> {
+    static constexpr auto fields = std::make_tuple(
+            jsonField("type", &ChannelSubscriptionResponse::m_type),
+            jsonField("channel", &ChannelSubscriptionResponse::m_channel),
+            jsonField("market", &ChannelSubscriptionResponse::m_market),
+            jsonField("code", &ChannelSubscriptionResponse::m_code),
+            jsonField("msg", &ChannelSubscriptionResponse::m_msg)
+    );
+};
+
 struct AuthenticationRequest : public IJson {
     Operation m_op = Operation::login;
     std::string m_key;
@@ -271,25 +405,238 @@ struct TickerData : public IJson {
     void fromJson(const nlohmann::json &json) override;
 };
 
+template<>
+struct JsonFields<TickerData> {
+    static constexpr auto fields = std::make_tuple(
+            jsonField("bid", &TickerData::m_bid),
+            jsonField("ask", &TickerData::m_ask),
+            jsonField("bidSize", &TickerData::m_bidSize),
+            jsonField("askSize", &TickerData::m_askSize),
+            jsonField("last", &TickerData::m_last),
+            jsonField("time", &TickerData::m_time)
+    );
+};
+
+/**
+ * Number text as written in the received JSON, FTX computes the order book checksum over the original formatting.
+ * Longer texts are truncated, which only makes the checksum fail and the book resync.
+ */
+struct NumberText {
+    static constexpr std::size_t CAPACITY = 23;
+
+    std::array<char, CAPACITY> m_chars{};
+    std::uint8_t m_size = 0;
+
+    void assign(std::string_view text) {
+        m_size = static_cast<std::uint8_t>(std::min(text.size(), CAPACITY));
+        std::copy_n(text.data(), m_size, m_chars.data());
+    }
+
+    [[nodiscard]] std::string_view view() const {
+        return {m_chars.data(), m_size};
+    }
+};
+
+/// One cache line per price level
+struct OrderBookLevel {
+    double m_price = 0.0;
+    double m_size = 0.0;
+    NumberText m_priceText;
+    NumberText m_sizeText;
+};
+
+/**
+ * Price levels written as [[price, size], ...]
+ */
+struct OrderBookLevelsCodec {
+    static bool read(JsonReader &reader, std::vector<OrderBookLevel> &levels) {
+        levels.clear();
+
+        if (reader.readNull()) {
+            return true;
+        }
+
+        if (!reader.beginArray()) {
+            return false;
+        }
+
+        while (reader.nextElement()) {
+            auto &level = levels.emplace_back();
+            std::string_view text;
+
+            if (!reader.beginArray() || !reader.nextElement() || !reader.readNumber(level.m_price, text)) {
+                return false;
+            }
+
+            level.m_priceText.assign(text);
+
+            if (!reader.nextElement() || !reader.readNumber(level.m_size, text)) {
+                return false;
+            }
+
+            level.m_sizeText.assign(text);
+
+            while (reader.nextElement()) {
+                reader.skipValue();
+            }
+        }
+
+        return !reader.failed();
+    }
+
+    static void fromJson(const nlohmann::json &json, std::vector<OrderBookLevel> &levels) {
+        levels.clear();
+
+        for (const auto &el: json) {
+            auto &level = levels.emplace_back();
+            level.m_price = el.at(0).get<double>();
+            level.m_size = el.at(1).get<double>();
+            level.m_priceText.assign(el.at(0).dump());
+            level.m_sizeText.assign(el.at(1).dump());
+        }
+    }
+
+    static nlohmann::json toJson(const std::vector<OrderBookLevel> &levels) {
+        nlohmann::json json = nlohmann::json::array();
+
+        for (const auto &level: levels) {
+            json.push_back({level.m_price, level.m_size});
+        }
+
+        return json;
+    }
+};
+
 struct OrderBookData : public IJson {
+    OperationResponse m_action = OperationResponse::partial;
+
+    /// Seconds from epoch
+    double m_time = 0.0;
+    std::uint32_t m_checksum = 0;
+    std::vector<OrderBookLevel> m_bids;
+    std::vector<OrderBookLevel> m_asks;
+
+    [[nodiscard]] nlohmann::json toJson() const override;
 
-    [[nodiscard]] nlohmann::json toJson() const override { return nlohmann::json{}; };
+    void fromJson(const nlohmann::json &json) override;
+};
 
-    void fromJson(const nlohmann::json &json) override {};
+template<>
+struct JsonFields<OrderBookData> {
+    static constexpr auto fields = std::make_tuple(
+            jsonField("action", &OrderBookData::m_action),
+            jsonField("time", &OrderBookData::m_time),
+            jsonField("checksum", &OrderBookData::m_checksum),
+            jsonField<OrderBookLevelsCodec>("bids", &OrderBookData::m_bids),
+            jsonField<OrderBookLevelsCodec>("asks", &OrderBookData::m_asks)
+    );
+};
+
+/**
+ * Markets keyed by their names as sent by the markets channel, {"BTC-PERP": {...}, ...}
+ */
+struct MarketMapCodec {
+    static bool read(JsonReader &reader, std::vector<Market> &markets) {
+        std::string_view key;
+        markets.clear();
+
+        if (reader.readNull()) {
+            return true;
+        }
+
+        if (!reader.beginObject()) {
+            return false;
+        }
+
+        while (reader.nextKey(key)) {
+            auto &market = markets.emplace_back();
+
+            if (!readJsonFields(reader, market)) {
+                return false;
+            }
+
+            if (market.m_name.empty()) {
+                market.m_name = key;
+            }
+        }
+
+        return !reader.failed();
+    }
+
+    static void fromJson(const nlohmann::json &json, std::vector<Market> &markets) {
+        markets.clear();
+
+        for (auto it = json.begin(); it != json.end(); ++it) {
+            auto &market = markets.emplace_back();
+            fromJsonFields(it.value(), market);
+
+            if (market.m_name.empty()) {
+                market.m_name = it.key();
+            }
+        }
+    }
+
+    static nlohmann::json toJson(const std::vector<Market> &markets) {
+        nlohmann::json json = nlohmann::json::object();
+
+        for (const auto &market: markets) {
+            json[market.m_name] = toJsonFields(market);
+        }
+
+        return json;
+    }
 };
 
 struct MarketsData : public IJson {
+    OperationResponse m_action = OperationResponse::partial;
+    std::vector<Market> m_markets;
 
-    [[nodiscard]] nlohmann::json toJson() const override { return nlohmann::json{}; };
+    [[nodiscard]] nlohmann::json toJson() const override;
 
-    void fromJson(const nlohmann::json &json) override {};
+    void fromJson(const nlohmann::json &json) override;
+};
+
+template<>
+struct JsonFields<MarketsData> {
+    static constexpr auto fields = std::make_tuple(
+            jsonField("action", &MarketsData::m_action),
+            jsonField<MarketMapCodec>("data", &MarketsData::m_markets)
+    );
+};
+
+struct Trade : public IJson {
+    std::int64_t m_id = -1;
+    double m_price = 0.0;
+    double m_size = 0.0;
+    Side m_side = Side::buy;
+    bool m_liquidation = false;
+
+    /// Microseconds from epoch
+    std::int64_t m_time = 0;
+
+    [[nodiscard]] nlohmann::json toJson() const override;
+
+    void fromJson(const nlohmann::json &json) override;
+};
+
+template<>
+struct JsonFields<Trade> {
+    static constexpr auto fields = std::make_tuple(
+            jsonField("id", &Trade::m_id),
+            jsonField("price", &Trade::m_price),
+            jsonField("size", &Trade::m_size),
+            jsonField("side", &Trade::m_side),
+            jsonField("liquidation", &Trade::m_liquidation),
+            jsonField<TimestampCodec>("time", &Trade::m_time)
+    );
 };
 
 struct TradesData : public IJson {
+    std::vector<Trade> m_trades;
 
-    [[nodiscard]] nlohmann::json toJson() const override { return nlohmann::json{}; };
+    [[nodiscard]] nlohmann::json toJson() const override;
 
-    void fromJson(const nlohmann::json &json) override {};
+    void fromJson(const nlohmann::json &json) override;
 };
 
 struct FillData : public IJson {
@@ -304,7 +651,9 @@ struct FillData : public IJson {
     double m_price = 0.0;
     Side m_side = Side::buy;
     double m_size = 0;
-    std::string m_time;
+
+    /// Microseconds from epoch
+    std::int64_t m_time = 0;
     std::string m_type;
 
     [[nodiscard]] nlohmann::json toJson() const override;
@@ -312,6 +661,25 @@ struct FillData : public IJson {
     void fromJson(const nlohmann::json &json) override;
 };
 
+template<>
+struct JsonFields<FillData> {
+    static constexpr auto fields = std::make_tuple(
+            jsonField("fee", &FillData::m_fee),
+            jsonField("feeRate", &FillData::m_feeRate),
+            jsonField("future", &FillData::m_future),
+            jsonField("id", &FillData::m_id),
+            jsonField("liquidity", &FillData::m_liquidity),
+            jsonField("market", &FillData::m_market),
+            jsonField("orderId", &FillData::m_orderId),
+            jsonField("tradeId", &FillData::m_tradeId),
+            jsonField("price", &FillData::m_price),
+            jsonField("side", &FillData::m_side),
+            jsonField("size", &FillData::m_size),
+            jsonField<TimestampCodec>("time", &FillData::m_time),
+            jsonField("type", &FillData::m_type)
+    );
+};
+
 struct OrderData : public IJson {
     std::int64_t m_id = -1;
     std::string m_clientId;
@@ -333,6 +701,42 @@ struct OrderData : public IJson {
     void fromJson(const nlohmann::json &json) override;
 };
 
+template<>
+struct JsonFields<OrderData> {
+    static constexpr auto fields = std::make_tuple(
+            jsonField("id", &OrderData::m_id),
+            jsonField("clientId", &OrderData::m_clientId),
+            jsonField("market", &OrderData::m_market),
+            jsonField("type", &OrderData::m_type),
+            jsonField("side", &OrderData::m_side),
+            jsonField("size", &OrderData::m_size),
+            jsonField("price", &OrderData::m_price),
+            jsonField("reduceOnly", &OrderData::m_reduceOnly),
+            jsonField("ioc", &OrderData::m_ioc),
+            jsonField("postOnly", &OrderData::m_postOnly),
+            jsonField("status", &OrderData::m_status),
+            jsonField("filledSize", &OrderData::m_filledSize),
+            jsonField("remainingSize", &OrderData::m_remainingSize),
+            jsonField("avgFillPrice", &OrderData::m_avgFillPrice)
+    );
+};
+
+struct Fills : public IJson {
+    std::vector<FillData> m_fills;
+
+    [[nodiscard]] nlohmann::json toJson() const override;
+
+    void fromJson(const nlohmann::json &json) override;
+};
+
+struct Orders : public IJson {
+    std::vector<OrderData> m_orders;
+
+    [[nodiscard]] nlohmann::json toJson() const override;
+
+    void fromJson(const nlohmann::json &json) override;
+};
+
 struct FTXPayData : public IJson {
     std::string m_status;
     nlohmann::json m_app;
@@ -0,0 +1,72 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_ORDER_BOOK_H
+#define FTX_ORDER_BOOK_H
+
+#include <ftx_api/ftx_models.h>
+#include <cstdint>
+#include <vector>
+
+namespace ftx {
+
+/**
+ * Local order book of a single market maintained from the orderbook channel. Price levels of each side are kept in
+ * a flat array sorted from the best price, updates are applied by a binary search. Not thread-safe.
+ */
+class OrderBook {
+
+    /// Highest price first
+    std::vector<OrderBookLevel> m_bids;
+
+    /// Lowest price first
+    std::vector<OrderBookLevel> m_asks;
+    double m_time = 0.0;
+    bool m_valid = false;
+
+public:
+
+    /// Number of levels of each side covered by the FTX checksum
+    static constexpr std::size_t CHECKSUM_DEPTH = 100;
+
+    /**
+     * Apply a partial snapshot or an incremental update and verify the checksum. Updates received before the first
+     * partial are ignored.
+     * @param data
+     * @return False if the checksum does not match, the book is then cleared and must be resynchronized
+     */
+    bool apply(const OrderBookData &data);
+
+    /**
+     * Drop all levels, the book is invalid until the next partial
+     */
+    void clear();
+
+    /**
+     * CRC32 of "bid:size:ask:size:..." of the top CHECKSUM_DEPTH levels, numbers formatted as received
+     */
+    [[nodiscard]] std::uint32_t checksum() const;
+
+    /**
+     * @return True if a partial was received and all checksums since then matched
+     */
+    [[nodiscard]] bool isValid() const { return m_valid; }
+
+    [[nodiscard]] const std::vector<OrderBookLevel> &bids() const { return m_bids; }
+
+    [[nodiscard]] const std::vector<OrderBookLevel> &asks() const { return m_asks; }
+
+    /**
+     * Time of the last applied data in seconds from epoch
+     */
+    [[nodiscard]] double time() const { return m_time; }
+};
+}
+
+#endif //FTX_ORDER_BOOK_H
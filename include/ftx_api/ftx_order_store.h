@@ -0,0 +1,112 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_ORDER_STORE_H
+#define FTX_ORDER_STORE_H
+
+#include <ftx_api/ftx_models.h>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ftx {
+
+/**
+ * Latest known state of orders received via WebSocket, indexed by the exchange and the client order id. Closed orders
+ * are retained in a ring of MAX_CLOSED_ORDERS, the oldest are forgotten. Not thread-safe.
+ */
+class OrderStore {
+
+    struct Entry {
+        OrderData m_data;
+
+        /// Set by each update, cleared when the state is taken
+        bool m_unread = true;
+    };
+
+    std::unordered_map<std::int64_t, Entry> m_orders;
+    std::unordered_map<std::string, std::int64_t> m_clientIds;
+    std::deque<std::int64_t> m_closedOrders;
+
+    Entry *find(const Order &order);
+
+    void forget(std::int64_t id);
+
+public:
+
+    static constexpr std::size_t MAX_CLOSED_ORDERS = 1024;
+
+    /**
+     * Store a new state of an order, updates of a closed order are ignored
+     * @param orderData
+     */
+    void add(const OrderData &orderData);
+
+    /**
+     * @param order matched by the exchange id or by the client id
+     * @return Latest state of the order not taken yet
+     */
+    [[nodiscard]] std::optional<OrderData> take(const Order &order);
+
+    /**
+     * @param order matched by the exchange id or by the client id
+     * @return Final state of the order if it is closed
+     */
+    [[nodiscard]] std::optional<OrderData> takeClosed(const Order &order);
+
+    /**
+     * @param order matched by the exchange id or by the client id
+     * @return State of the order if it is open and nothing is filled yet, i.e. it rests on the book
+     */
+    [[nodiscard]] std::optional<OrderData> takeResting(const Order &order);
+
+    [[nodiscard]] std::size_t size() const;
+};
+
+/**
+ * Fills received via WebSocket or REST, indexed by the fill id and by the order id. At most MAX_FILLS most recent fills
+ * are retained. Not thread-safe.
+ */
+class FillStore {
+
+    struct Entry {
+        FillData m_data;
+        bool m_unread = true;
+    };
+
+    std::unordered_map<std::int64_t, Entry> m_fills;
+    std::unordered_map<std::int64_t, std::vector<std::int64_t>> m_orderFills;
+    std::deque<std::int64_t> m_fillIds;
+
+    void forget(std::int64_t id);
+
+public:
+
+    static constexpr std::size_t MAX_FILLS = 4096;
+
+    /**
+     * @param fillData
+     * @return False if the fill is already stored
+     */
+    bool add(const FillData &fillData);
+
+    /**
+     * @param order matched by the exchange id
+     * @return Oldest fill of the order not taken yet
+     */
+    [[nodiscard]] std::optional<FillData> take(const Order &order);
+
+    [[nodiscard]] std::size_t size() const;
+};
+}
+
+#endif //FTX_ORDER_STORE_H
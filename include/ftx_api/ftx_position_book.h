@@ -0,0 +1,81 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_POSITION_BOOK_H
+#define FTX_POSITION_BOOK_H
+
+#include <ftx_api/ftx_models.h>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ftx {
+
+/**
+ * Thread-safe in-memory book of futures positions keyed by the future name. Seeded from the REST positions,
+ * updated by fills and reconciled by reloading the REST positions.
+ */
+class PositionBook {
+
+    mutable std::shared_mutex m_locker;
+    std::unordered_map<std::string, Position> m_positions;
+    bool m_loaded = false;
+
+    /// Set by clear(), snapshots are refused until resume() as the fills are not being received
+    bool m_suspended = false;
+
+    /// Incremented by each applied fill, a snapshot is only valid if no fill was applied while it was requested
+    std::uint64_t m_sequence = 0;
+
+public:
+
+    /**
+     * Replace the book with a REST snapshot unless a fill was applied since the snapshot was requested
+     * @param positions
+     * @param sequence value of sequence() read before the snapshot was requested
+     * @return False if the snapshot is outdated or the book is suspended, the snapshot was dropped
+     */
+    bool load(const std::vector<Position> &positions, std::uint64_t sequence);
+
+    /**
+     * Apply a fill, spot fills are ignored
+     * @param fill
+     */
+    void apply(const FillData &fill);
+
+    /**
+     * Forget all positions and suspend the book when the fills stream is lost, the book is not valid until resume()
+     * and the next load
+     */
+    void clear();
+
+    /**
+     * Accept snapshots again once the fills stream is restored
+     */
+    void resume();
+
+    [[nodiscard]] std::uint64_t sequence() const;
+
+    /**
+     * @return True if the book was loaded
+     */
+    [[nodiscard]] bool isValid() const;
+
+    /**
+     * @param future future name e.g. BTC-PERP
+     * @return Position, an empty one when there is no position, nothing if the book is not valid
+     */
+    [[nodiscard]] std::optional<Position> find(const std::string &future) const;
+};
+}
+
+#endif //FTX_POSITION_BOOK_H
@@ -0,0 +1,87 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_RATE_LIMITER_H
+#define FTX_RATE_LIMITER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <enum.h>
+#include <spimpl.h>
+
+namespace ftx {
+
+/// Scheduling class of a REST request, the first one is served first
+BETTER_ENUM(RequestPriority, std::int32_t,
+            order,
+            account,
+            marketData,
+            history
+)
+
+struct RateLimiterMetrics {
+    /// Number of requests waiting right now
+    std::size_t m_queueDepth = 0;
+    std::uint64_t m_numRequests = 0;
+
+    /// Number of requests which had to wait for tokens or for requests of higher priority
+    std::uint64_t m_numDelayed = 0;
+    std::int64_t m_totalWaitUs = 0;
+    std::int64_t m_maxWaitUs = 0;
+};
+
+/**
+ * Process-wide token bucket shared by all REST sessions, FTX limits the request rate per account and IP. Waiting
+ * requests are served by priority, FIFO within the same priority.
+ */
+class RateLimiter {
+
+    struct P;
+    spimpl::unique_impl_ptr<P> m_p{};
+
+    RateLimiter();
+
+public:
+
+    RateLimiter(const RateLimiter &) = delete;
+
+    RateLimiter &operator=(const RateLimiter &) = delete;
+
+    /**
+     * Get the process-wide instance
+     * @return
+     */
+    static RateLimiter &instance();
+
+    /**
+     * Set the sustained rate and the bucket size, default is 30 requests per second with the burst of 30
+     * @param requestsPerSecond
+     * @param burst
+     */
+    void setLimit(double requestsPerSecond, double burst);
+
+    [[nodiscard]] double requestsPerSecond() const;
+
+    /**
+     * Block until the request may be sent
+     * @param weight cost of the request in tokens, clamped to the bucket size
+     * @param priority
+     */
+    void acquire(double weight, RequestPriority priority);
+
+    [[nodiscard]] RateLimiterMetrics metrics() const;
+
+    /**
+     * Zero the counters, the queue depth is kept
+     */
+    void resetMetrics();
+};
+}
+
+#endif //FTX_RATE_LIMITER_H
@@ -15,6 +15,8 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 #include <memory>
 #include <functional>
 #include <optional>
+#include <future>
+#include <chrono>
 #include <spimpl.h>
 
 namespace ftx {
@@ -29,6 +31,8 @@ public:
 
     RESTClient(const std::string &apiKey, const std::string &apiSecret, const std::string &subAccountName);
 
+    ~RESTClient();
+
     /**
      * Set credentials to the RESTClient instance
      * @param apiKey
@@ -45,6 +49,15 @@ public:
      */
     bool static isValidCandleResolution(std::int32_t resolution);
 
+    /**
+     * Set for how long results of account, positions and markets requests are reused, 0 (default) disables the
+     * cache. Identical requests running at the same time share one request regardless of this setting.
+     * @param maxAge
+     */
+    void setMaxAge(std::chrono::milliseconds maxAge);
+
+    [[nodiscard]] std::chrono::milliseconds maxAge() const;
+
     /**
      * Get Account information - https://docs.ftx.com/#account
      * @return Account structure
@@ -58,6 +71,12 @@ public:
      */
     [[nodiscard]] Market getMarket(const std::string &name) const;
 
+    /**
+     * Get information of all Markets in a single request - https://docs.ftx.com/#get-markets
+     * @return vector of Market structures
+     */
+    [[nodiscard]] std::vector<Market> getMarkets() const;
+
     /**
      * Get Position information - https://docs.ftx.com/#get-positions
      * @param name market name e.g. BTC-PERP
@@ -67,9 +86,11 @@ public:
 
     /**
      * Get Positions information - https://docs.ftx.com/#get-positions
+     * @param fresh if true then a new request is sent, neither a running identical request nor the cache is used
+     * (e.g. for a snapshot which must be requested after a given moment)
      * @return array of Position structures
      */
-    [[nodiscard]] std::vector<Position> getPositions() const;
+    [[nodiscard]] std::vector<Position> getPositions(bool fresh = false) const;
 
     /**
      * Place order
@@ -102,7 +123,32 @@ public:
     [[nodiscard]] bool cancelAllOrders(const std::string &market) const;
 
     /**
-     * Download historical candles
+     * Get fills in a time range - https://docs.ftx.com/#fills
+     * @param from timestamp in s, 0 means no lower bound
+     * @param to timestamp in s, 0 means no upper bound
+     * @return array of FillData structures, newest first
+     */
+    [[nodiscard]] std::vector<FillData> getFills(std::int64_t from, std::int64_t to = 0) const;
+
+    /**
+     * Get order history in a time range - https://docs.ftx.com/#get-order-history
+     * @param from timestamp in s, 0 means no lower bound
+     * @param to timestamp in s, 0 means no upper bound
+     * @return array of OrderData structures, newest first
+     */
+    [[nodiscard]] std::vector<OrderData> getOrderHistory(std::int64_t from, std::int64_t to = 0) const;
+
+    /**
+     * Set number of history windows downloaded concurrently by getHistoricalPrices, 1 (default) means serial
+     * downloading page by page. Windows are downloaded by the calling thread and the worker pool, so the effective
+     * concurrency is limited to the pool size plus one.
+     * @param concurrency
+     */
+    void setHistoryConcurrency(std::size_t concurrency);
+
+    /**
+     * Download historical candles. When history concurrency is greater than 1 then the range is split into
+     * windows of the maximal page size which are downloaded in parallel and merged in order
      * @param marketName market name e.g. BTC-PERP
      * @param resolutionInSecs 15, 60, 300, 900, 3600, 14400, 86400, or any multiple of 86400 up to 30*86400
      * @param from timestamp in s, must be smaller then "to"
@@ -112,6 +158,31 @@ public:
     [[nodiscard]] std::vector<Candle>
     getHistoricalPrices(const std::string &marketName, std::int32_t resolutionInSecs, std::int64_t from,
                         std::int64_t to) const;
+
+    /**
+     * Asynchronous variants of the methods above. Requests are executed by the RESTClient's worker pool using
+     * pooled keep-alive connections, so several requests can be in flight at once. The RESTClient instance
+     * must outlive all returned futures. Exceptions are rethrown by std::future::get().
+     */
+    [[nodiscard]] std::future<Account> getAccountInfoAsync() const;
+
+    [[nodiscard]] std::future<Market> getMarketAsync(const std::string &name) const;
+
+    [[nodiscard]] std::future<Position> getPositionAsync(const std::string &name) const;
+
+    [[nodiscard]] std::future<std::vector<Position>> getPositionsAsync() const;
+
+    [[nodiscard]] std::future<Order> placeOrderAsync(const Order &order) const;
+
+    [[nodiscard]] std::future<bool> cancelOrderAsync(std::int32_t id, bool isClientId = false) const;
+
+    [[nodiscard]] std::future<Order> getOrderStatusAsync(std::int32_t id, bool isClientId) const;
+
+    [[nodiscard]] std::future<bool> cancelAllOrdersAsync(const std::string &market) const;
+
+    [[nodiscard]] std::future<std::vector<Candle>>
+    getHistoricalPricesAsync(const std::string &marketName, std::int32_t resolutionInSecs, std::int64_t from,
+                             std::int64_t to) const;
 };
 }
 #endif //FTX_REST_CLIENT_H
@@ -0,0 +1,63 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_SSL_CONTEXT_H
+#define FTX_SSL_CONTEXT_H
+
+#include <boost/asio/ssl/context.hpp>
+#include <string>
+#include <spimpl.h>
+
+namespace ftx {
+
+/**
+ * Process-wide TLS client context shared by all REST and WebSocket connections. Keeps the last TLS session
+ * (session ID or session ticket) per host so that new connections and reconnects can resume it instead of doing
+ * a full handshake.
+ */
+class SSLContextFactory {
+
+    struct P;
+    spimpl::unique_impl_ptr<P> m_p{};
+
+    SSLContextFactory();
+
+public:
+
+    SSLContextFactory(const SSLContextFactory &) = delete;
+
+    SSLContextFactory &operator=(const SSLContextFactory &) = delete;
+
+    /**
+     * Get the process-wide instance
+     * @return
+     */
+    static SSLContextFactory &instance();
+
+    /**
+     * Get the shared TLS client context, default verify paths are loaded only once
+     * @return
+     */
+    boost::asio::ssl::context &context();
+
+    /**
+     * Prepare SSL handle for handshake - set SNI hostname and attach a cached session for the host if any
+     * @param ssl native handle of the SSL stream
+     * @param host e.g. "ftx.com"
+     * @return False if SNI hostname cannot be set
+     */
+    bool prepareSession(SSL *ssl, const std::string &host);
+
+    /**
+     * Drop all cached sessions
+     */
+    void clearSessions();
+};
+}
+#endif //FTX_SSL_CONTEXT_H
@@ -0,0 +1,47 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_T6_H
+#define FTX_T6_H
+
+#include <ftx_api/ftx_models.h>
+#include <cstddef>
+#include <vector>
+
+namespace ftx {
+
+/**
+ * Binary layout of the Zorro T6 record (see zorro/trading.h), declared here so the conversion does not depend
+ * on the Windows headers
+ */
+struct T6Record {
+    /// OLE Automation date (DATE) of the candle start, GMT
+    double m_time;
+    float m_high;
+    float m_low;
+    float m_open;
+    float m_close;
+    float m_val;
+    float m_vol;
+};
+
+static_assert(sizeof(T6Record) == 32, "T6Record must match the Zorro T6 layout");
+
+/**
+ * Convert the most recent candles into T6 records ordered from the most recent to the oldest, as expected by
+ * BrokerHistory2. Prices are narrowed to float two at a time using SSE2 when available.
+ * @param candles candles ordered from the oldest to the most recent
+ * @param maxCount maximum number of records to write
+ * @param records output buffer of at least maxCount records
+ * @return number of records written
+ */
+std::size_t convertCandlesToT6(const std::vector<Candle> &candles, std::size_t maxCount, T6Record *records);
+}
+
+#endif //FTX_T6_H
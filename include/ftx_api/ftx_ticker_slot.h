@@ -0,0 +1,85 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef FTX_TICKER_SLOT_H
+#define FTX_TICKER_SLOT_H
+
+#include <ftx_api/ftx_models.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace ftx {
+
+/**
+ * Seqlock protected TickerData snapshot, written only by the WebSocket IO thread. Readers never block the writer,
+ * they retry when they observe an odd or changed sequence number.
+ */
+struct TickerSlot {
+    std::atomic<std::uint64_t> m_sequence = 0;
+    std::atomic<double> m_bid = 0.0;
+    std::atomic<double> m_ask = 0.0;
+    std::atomic<double> m_bidSize = 0.0;
+    std::atomic<double> m_askSize = 0.0;
+    std::atomic<double> m_last = 0.0;
+    std::atomic<std::int64_t> m_time = 0;
+
+    /// Set while the stream is disconnected, cleared by the first fresh tick
+    std::atomic<bool> m_stale = false;
+
+    /// @return True if this was the first write into the slot
+    bool store(const TickerData &tickerData) {
+        const auto sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_bid.store(tickerData.m_bid, std::memory_order_relaxed);
+        m_ask.store(tickerData.m_ask, std::memory_order_relaxed);
+        m_bidSize.store(tickerData.m_bidSize, std::memory_order_relaxed);
+        m_askSize.store(tickerData.m_askSize, std::memory_order_relaxed);
+        m_last.store(tickerData.m_last, std::memory_order_relaxed);
+        m_time.store(tickerData.m_time, std::memory_order_relaxed);
+
+        m_sequence.store(sequence + 2, std::memory_order_release);
+        m_stale.store(false, std::memory_order_release);
+        return sequence == 0;
+    }
+
+    /// @return False if nothing was written into the slot yet
+    bool load(TickerData &tickerData) const {
+        for (;;) {
+            const auto sequence = m_sequence.load(std::memory_order_acquire);
+
+            if (sequence == 0) {
+                return false;
+            }
+
+            if (sequence & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            tickerData.m_bid = m_bid.load(std::memory_order_relaxed);
+            tickerData.m_ask = m_ask.load(std::memory_order_relaxed);
+            tickerData.m_bidSize = m_bidSize.load(std::memory_order_relaxed);
+            tickerData.m_askSize = m_askSize.load(std::memory_order_relaxed);
+            tickerData.m_last = m_last.load(std::memory_order_relaxed);
+            tickerData.m_time = m_time.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (m_sequence.load(std::memory_order_relaxed) == sequence) {
+                return true;
+            }
+        }
+    }
+};
+}
+
+#endif //FTX_TICKER_SLOT_H
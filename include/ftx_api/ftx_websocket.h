@@ -12,6 +12,7 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 
 #include <spimpl.h>
 #include <string>
+#include <string_view>
 #include <functional>
 #include <ftx_api/ftx_models.h>
 #include <ftx_api/utils.h>
@@ -27,9 +28,9 @@ class WebSocket : public std::enable_shared_from_this<WebSocket> {
     struct P;
     spimpl::unique_impl_ptr<P> m_p{};
 
-    /// when 'false' returned the stop will called
-    using onMessageReceivedCB = std::function<bool(const char *fl, int ec, std::string errmsg, const char *ptr,
-                                                   std::size_t size)>;
+    /// when 'false' returned the stop will called, the frame view is valid only during the call
+    using onMessageReceivedCB = std::function<bool(const char *fl, int ec, std::string errmsg,
+                                                   std::string_view frame)>;
 
     using holderType = std::shared_ptr<void>;
 
@@ -45,6 +46,13 @@ public:
 
     void stop();
 
+    /**
+     * Queue a request to be sent over the WebSocket, requests are sent in order once the connection is
+     * established. Thread-safe.
+     * @param request
+     */
+    void send(const nlohmann::json &request);
+
     std::string streamName() const;
 
     void setStreamName(const std::string &streamName);
@@ -32,6 +32,9 @@ class WebSocketClient {
 
 public:
 
+    /// Called when a multiplexed connection goes down or is up again, with names of the affected streams
+    using onConnectionStateCB = std::function<void(bool connected, const std::vector<std::string> &streamNames)>;
+
     WebSocketClient(const WebSocketClient &) = delete;
 
     WebSocketClient &operator=(const WebSocketClient &) = delete;
@@ -91,6 +94,35 @@ public:
      */
     void unsubscribeAll();
 
+    /**
+     * Set multiplexed mode. In multiplexed mode (default) all channel subscriptions share a single authenticated
+     * WebSocket connection (new connections are opened only when a connection carries too many subscriptions)
+     * and incoming frames are dispatched by their channel and market. Otherwise every subscription opens its own
+     * connection. Must be set before the first subscription.
+     * @param multiplexed
+     */
+    void setMultiplexed(bool multiplexed);
+
+    /**
+     * Check if multiplexed mode is set
+     * @return True if multiplexed
+     */
+    [[nodiscard]] bool isMultiplexed() const;
+
+    /**
+     * Set automatic reconnect of multiplexed connections (default on). A lost connection is re-established with
+     * exponential backoff and jitter, logged in again and all its subscriptions are replayed, subscription
+     * handles stay valid. When off, subscriptions of a lost connection get an error and are removed.
+     * @param autoReconnect
+     */
+    void setAutoReconnect(bool autoReconnect);
+
+    /**
+     * Set callback notified when a multiplexed connection is lost or re-established
+     * @param onConnectionStateCB
+     */
+    void setConnectionStateCallback(const onConnectionStateCB &onConnectionStateCB);
+
     /**
      * Set logger callback, if no set then all errors are writen to the stderr stream only
      * @param onLogMessageCB
@@ -120,6 +152,30 @@ public:
      */
     WebSocket::handle markets(const std::string &pair, onEventCB cb);
 
+    /**
+     * Subscribe WebSocket to the Orderbook channel
+     * @param pair currency pair e.g. BTCUSDT
+     * @param cb handle to process the incoming data
+     * @return WebSocket handle
+     */
+    WebSocket::handle orderBook(const std::string &pair, onEventCB cb);
+
+    /**
+     * Subscribe WebSocket to the Trades channel
+     * @param pair currency pair e.g. BTCUSDT
+     * @param cb handle to process the incoming data
+     * @return WebSocket handle
+     */
+    WebSocket::handle trades(const std::string &pair, onEventCB cb);
+
+    /**
+     * Unsubscribe and subscribe a channel again on its connection, the subscription callback and handle are kept.
+     * Used to receive a fresh snapshot (e.g. an orderbook partial). Can be called from a subscription callback.
+     * @param pair currency pair e.g. BTCUSDT, empty for the private channels
+     * @param channel
+     */
+    void resubscribe(const std::string &pair, Channel channel);
+
     /**
      * Subscribe WebSocket to the Orders channel
      * @param cb handle to process the incoming data
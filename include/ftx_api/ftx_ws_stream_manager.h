@@ -12,10 +12,17 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 
 #include <ftx_api/utils.h>
 #include <ftx_api/ftx_models.h>
+#include <ftx_api/ftx_order_book.h>
+#include <ftx_api/ftx_bar_builder.h>
+#include <ftx_api/ftx_market_cache.h>
+#include <ftx_api/ftx_position_book.h>
+#include <chrono>
+#include <memory>
 #include <optional>
 #include <spimpl.h>
 
 namespace ftx {
+class RESTClient;
 
 class WSStreamManager {
 
@@ -24,7 +31,15 @@ class WSStreamManager {
 
 public:
 
-    WSStreamManager(const std::string &apiKey, const std::string &apiSecret, const std::string &subAccountName);
+    /**
+     * @param apiKey
+     * @param apiSecret
+     * @param subAccountName
+     * @param restClient client used for the bulk loads and for the reconciliation after a reconnect, shared with the
+     * caller so that a single worker and connection pool is used
+     */
+    WSStreamManager(const std::string &apiKey, const std::string &apiSecret, const std::string &subAccountName,
+                    std::shared_ptr<RESTClient> restClient);
 
     ~WSStreamManager();
 
@@ -33,8 +48,35 @@ public:
      * is true then re-subscribe if ef already subscribed
      * @param pair e.g BTCUSDT
      * @param force If true then re-subscribe if already subscribed
+     * @return ticker index for the fast readTickerData overload, stable for the lifetime of the manager
+     */
+    std::size_t subscribeTickerStream(const std::string &pair, bool force = false);
+
+    /**
+     * Check if the Orderbook Stream is already subscribed for a selected pair, if not then subscribe it. The local
+     * book is resynchronized automatically when its checksum does not match. When force parameter is true then
+     * re-subscribe if already subscribed
+     * @param pair e.g BTC-PERP
+     * @param force If true then re-subscribe if already subscribed
+     */
+    void subscribeOrderBookStream(const std::string &pair, bool force = false);
+
+    /**
+     * Check if the Trades Stream is already subscribed for a selected pair, if not then subscribe it. Trades are
+     * aggregated into rolling bars at all FTX resolutions. When force parameter is true then re-subscribe if already
+     * subscribed
+     * @param pair e.g BTC-PERP
+     * @param force If true then re-subscribe if already subscribed
      */
-    void subscribeTickerStream(const std::string &pair, bool force = false);
+    void subscribeTradesStream(const std::string &pair, bool force = false);
+
+    /**
+     * Check if the Markets Stream is already subscribed, if not then load all markets by a single REST request and
+     * subscribe it. The market cache is kept current by the stream. When force parameter is true then re-subscribe
+     * if already subscribed
+     * @param force If true then re-subscribe if already subscribed
+     */
+    void subscribeMarketsStream(bool force = false);
 
     /**
      * Check if the Orders Stream is already subscribed, if not then subscribe it. When force parameter
@@ -50,6 +92,12 @@ public:
      */
     void subscribeFillsStream(bool force = false);
 
+    /**
+     * Load the positions by REST, subscribe the Fills Stream and start the periodic reconciliation of the position
+     * book with REST. Does nothing if the position book is already running.
+     */
+    void subscribePositionBook();
+
     /**
      * Set time of all reading operations
      * @param seconds
@@ -76,18 +124,76 @@ public:
     [[nodiscard]] std::optional<TickerData> readTickerData(const std::string &pair);
 
     /**
-     * Waits for FillData with given OrderId received via WebSocket and read it. It will block at most Timeout time.
+     * Try to read TickerData structure using the ticker index returned by subscribeTickerStream. Lock-free
+     * when the ticker has already been received, otherwise it will block at most Timeout time. Returns nothing
+     * immediately while the stream is disconnected and until the first tick after reconnect.
+     * @param index
+     * @return TickerData structure if successful
+     */
+    [[nodiscard]] std::optional<TickerData> readTickerData(std::size_t index);
+
+    /**
+     * Try to read a copy of the local order book. While there is no valid snapshot (before the first partial, during
+     * a resync or while the stream is disconnected) it will block at most Timeout time.
+     * @param pair
+     * @return OrderBook if successful
+     */
+    [[nodiscard]] std::optional<OrderBook> readOrderBook(const std::string &pair);
+
+    /**
+     * Read bars aggregated from the Trades Stream, never blocks. Only bars built from all their trades are returned,
+     * the bars are cleared when the stream is disconnected.
+     * @param pair
+     * @param resolutionInSecs one of BarBuilder::RESOLUTIONS
+     * @param from seconds from epoch
+     * @param to seconds from epoch
+     * @return bars ordered from the oldest, empty if none are available
+     */
+    [[nodiscard]] std::vector<Candle> readBars(const std::string &pair, std::int32_t resolutionInSecs,
+                                               std::int64_t from, std::int64_t to) const;
+
+    /**
+     * Read market metadata from the market cache, never blocks
+     * @param name market name e.g. BTC-PERP
+     * @return Market if cached
+     */
+    [[nodiscard]] std::optional<Market> readMarket(const std::string &name) const;
+
+    /**
+     * Read a position from the position book, never blocks
+     * @param future future name e.g. BTC-PERP
+     * @return Position, an empty one when there is no position, nothing while the book is not loaded (e.g. while
+     * the stream is disconnected)
+     */
+    [[nodiscard]] std::optional<Position> readPosition(const std::string &future) const;
+
+    /**
+     * Waits for FillData of the order with given OrderId received via WebSocket and read it, each fill is read once.
+     * It will block at most Timeout time.
      * @param order An ACK response returned when placing order by REST
      * @return FillData structure if successful
      */
     [[nodiscard]] std::optional<FillData> readFillData(const Order &order);
 
     /**
-     * Waits for OrderData with given OrderId received via WebSocket and read it. It will block at most Timeout time.
+     * Waits for an update of the order with given OrderId or ClientId received via WebSocket and read its latest
+     * state, each update is read once. It will block at most Timeout time.
      * @param order An ACK response returned when placing order by REST
      * @return OrderData structure if successful
      */
     [[nodiscard]] std::optional<OrderData> readOrderData(const Order &order);
+
+    /**
+     * Waits until the Orders Stream reports the order closed (filled, cancelled or expired) and read its final state,
+     * earlier updates of the order are dropped. Returns immediately while the private streams are disconnected or when
+     * the Orders Stream reports an error.
+     * @param order An ACK response returned when placing order by REST
+     * @param timeout maximum waiting time
+     * @param stopWhenResting if true then stop waiting as soon as the order is reported open with nothing filled
+     * @return OrderData structure if the order was closed (or is resting when stopWhenResting) in time
+     */
+    [[nodiscard]] std::optional<OrderData> readClosedOrderData(const Order &order, std::chrono::milliseconds timeout,
+                                                               bool stopWhenResting = false);
 };
 
 }
@@ -13,6 +13,10 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 #include <nlohmann/json.hpp>
 #include <chrono>
 #include <string>
+#include <string_view>
+#include <optional>
+#include <array>
+#include <bit>
 #include <enum.h>
 
 #define STRINGIZE_I(x) #x
@@ -79,13 +83,150 @@ bool readValue(const nlohmann::json &json, const std::string &key, ValueType &va
  */
 double readStringAsDouble(const nlohmann::json &json, const std::string &key, double defaultVal = 0.0);
 
+/// Character policies of PerfectHash, characters are folded before hashing and comparing
+struct CaseSensitive {
+    static constexpr char fold(char c) {
+        return c;
+    }
+};
+
+struct CaseInsensitive {
+    static constexpr char fold(char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+};
+
+/**
+ * Collision-free hash of a fixed key set, the seed is searched by the constructor (at compile time when constructed
+ * in a constant expression). A lookup is one hash, one table read and one comparison confirming the key.
+ * @tparam N number of keys
+ * @tparam CharPolicy CaseSensitive or CaseInsensitive
+ */
+template<std::size_t N, typename CharPolicy = CaseSensitive>
+struct PerfectHash {
+    static constexpr std::size_t TABLE_SIZE = std::bit_ceil(N * 4);
+
+    std::uint32_t m_seed = 0;
+    std::array<std::uint8_t, TABLE_SIZE> m_slots{};
+    std::array<std::string_view, N> m_keys{};
+
+    /// FNV-1a over the folded characters
+    static constexpr std::uint32_t hash(std::string_view key, std::uint32_t seed) {
+        std::uint32_t retVal = 2166136261u ^ seed;
+
+        for (const char c: key) {
+            retVal ^= static_cast<unsigned char>(CharPolicy::fold(c));
+            retVal *= 16777619u;
+        }
+
+        return retVal;
+    }
+
+    static constexpr bool equals(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            if (CharPolicy::fold(a[i]) != CharPolicy::fold(b[i])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    constexpr explicit PerfectHash(const std::array<std::string_view, N> &keys) : m_keys(keys) {
+        static_assert(N < 255, "Too many keys");
+
+        for (std::uint32_t seed = 0;; ++seed) {
+            bool collision = false;
+            m_slots = {};
+
+            for (std::size_t i = 0; i < N && !collision; ++i) {
+                auto &slot = m_slots[hash(keys[i], seed) & (TABLE_SIZE - 1)];
+
+                if (slot != 0) {
+                    collision = true;
+                } else {
+                    slot = static_cast<std::uint8_t>(i + 1);
+                }
+            }
+
+            if (!collision) {
+                m_seed = seed;
+                return;
+            }
+        }
+    }
+
+    /// @return index of the key or -1 if it is not in the set
+    [[nodiscard]] constexpr int find(std::string_view key) const {
+        const auto slot = m_slots[hash(key, m_seed) & (TABLE_SIZE - 1)];
+        return slot != 0 && equals(m_keys[slot - 1], key) ? slot - 1 : -1;
+    }
+};
+
+/**
+ * Case-insensitive perfect hash of the names of a Better Enum. The names of a Better Enum are not available at
+ * compile time (unless BETTER_ENUMS_CONSTEXPR_TO_STRING is defined) so the hash is built once on first use.
+ * @tparam EnumType
+ */
+template<typename EnumType>
+class EnumNameHash {
+    static constexpr std::size_t SIZE = EnumType::_size();
+
+    PerfectHash<SIZE, CaseInsensitive> m_hash;
+
+    static std::array<std::string_view, SIZE> names() {
+        std::array<std::string_view, SIZE> retVal;
+
+        for (std::size_t i = 0; i < SIZE; ++i) {
+            retVal[i] = EnumType::_from_index(i)._to_string();
+        }
+
+        return retVal;
+    }
+
+    EnumNameHash() : m_hash(names()) {
+    }
+
+public:
+
+    static const EnumNameHash &instance() {
+        static const EnumNameHash retVal;
+        return retVal;
+    }
+
+    [[nodiscard]] std::optional<EnumType> find(std::string_view name) const {
+        const auto index = m_hash.find(name);
+
+        if (index < 0) {
+            return {};
+        }
+
+        return EnumType::_from_index(static_cast<std::size_t>(index));
+    }
+};
+
+/**
+ * Non-throwing case-insensitive conversion of a name into a Better Enum value in constant time
+ * @tparam EnumType
+ * @param name
+ * @return enum value or nothing if the name is unknown
+ */
+template<typename EnumType>
+std::optional<EnumType> enumFromString(std::string_view name) {
+    return EnumNameHash<EnumType>::instance().find(name);
+}
+
 /**
  * Helper for reading a Better Enum value (http://github.com/aantron/better-enums) from nlohmann::json object.
  * @tparam ValueType
  * @param json
  * @param key
  * @param value
- * @param canThrow Function will throw an exception instead of silently ignoring a missing attribute
+ * @param canThrow Function will throw an exception instead of silently ignoring a missing attribute or an unknown name
  * @return true if succeeded and canThrow parameter is false
  */
 template<typename ValueType>
@@ -94,19 +235,27 @@ bool readEnum(const nlohmann::json &json, const std::string &key, ValueType &val
 
     it = json.find(key);
 
-    if (canThrow) {
-        if (!it.value().is_null()) {
-            value = ValueType::_from_string_nocase(it->get<std::string>().c_str());
+    if (it == json.end()) {
+        if (canThrow) {
+            throw std::out_of_range(key + " not found");
         }
+        return false;
+    }
+
+    if (it.value().is_null()) {
+        return true;
+    }
+
+    /// Unknown names leave the value untouched
+    if (const auto result = enumFromString<ValueType>(it->get_ref<const std::string &>())) {
+        value = *result;
         return true;
-    } else {
-        if (it != json.end()) {
-            if (!it.value().is_null()) {
-                value = ValueType::_from_string_nocase(it->get<std::string>().c_str());
-            }
-            return true;
-        }
     }
+
+    if (canThrow) {
+        throw std::invalid_argument(key + ": unknown value " + it->get<std::string>());
+    }
+
     return false;
 }
 
@@ -167,6 +316,40 @@ inline bool string2bool(std::string v) {
     return !v.empty() && (v == "true" || atoi(v.c_str()) != 0);
 }
 
+inline constexpr std::int64_t MICROSECONDS_PER_SECOND = 1000000;
+
+/**
+ * Days since the Unix epoch of a proleptic Gregorian date - http://howardhinnant.github.io/date_algorithms.html
+ * @param year
+ * @param month 1..12
+ * @param day 1..31
+ * @return days from 1970-01-01, negative before
+ */
+constexpr std::int64_t daysFromCivil(std::int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const auto yoe = static_cast<unsigned>(year - era * 400);
+    const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+/**
+ * Parse a fixed-format UTC timestamp as sent by FTX, locale independent
+ * @param timeString "YYYY-MM-DDTHH:MM:SS", optionally followed by up to 6 fractional digits and a "Z" or "+HH:MM"
+ * offset, e.g. "2022-01-28T21:45:00+00:00" or "2019-03-05T09:56:55.728933+00:00"
+ * @param microseconds microseconds from epoch
+ * @return False if the string does not match the format
+ */
+bool parseTimestamp(std::string_view timeString, std::int64_t &microseconds);
+
+/**
+ * Convert microseconds from epoch into the OLE Automation date used by Zorro (days since 1899-12-30)
+ */
+inline double microsecondsToVariantTime(std::int64_t microseconds) {
+    return 25569. + static_cast<double>(microseconds) / (86400. * MICROSECONDS_PER_SECOND);
+}
+
 /**
  * Same as std::mktime but does not convert into local time, uses UTC instead
  * @param ptm
@@ -179,8 +362,24 @@ time_t mkgmtime(const struct tm *ptm);
  * @param timeString e.g. "2022-01-28T21:45:00+00:00"
  * @param format e.g. "%Y-%m-%dT%H:%M:%S:%z"
  * @return seconds from epoch
+ * @note Timestamps matching parseTimestamp are parsed without the format, other ones through std::get_time
  */
 int64_t getTimeStampFromString(const std::string &timeString, const std::string &format);
 
+/**
+ * A helper for converting the Unix timestamp into the date-time string in the FTX format
+ * @param timeStamp seconds from epoch
+ * @return e.g. "2022-01-28T21:45:00+00:00"
+ */
+std::string getStringFromTimeStamp(std::int64_t timeStamp);
+
+/**
+ * A helper for converting microseconds from epoch into the date-time string in the FTX format, the fraction is written
+ * only if not zero
+ * @param microseconds microseconds from epoch
+ * @return e.g. "2019-03-05T09:56:55.728933+00:00"
+ */
+std::string getStringFromMicroseconds(std::int64_t microseconds);
+
 }
 #endif //UTILS_H
@@ -12,12 +12,14 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 #include <ftx_api/utils.h>
 #include <ftx_api/ftx_rest_client.h>
 #include <ftx_api/ftx_ws_stream_manager.h>
+#include <ftx_api/ftx_candle_store.h>
+#include <ftx_api/ftx_t6.h>
+#include <ftx_api/ftx_rate_limiter.h>
 #include <wtypes.h>
 #include <string>
 #include <chrono>
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/basic_file_sink.h>
-#include <iomanip>
 #include <algorithm>
 
 #define PLUGIN_VERSION    2
@@ -32,9 +34,13 @@ static int lastOrderId = 0;
 static int orderType = 0;
 static double lotAmount = 1.0;
 static int loopMs = 50;     // Actually unused
-static int waitMs = 30000;  // Actually unused
-static std::unique_ptr<ftx::RESTClient> ftxClient;
+static int waitMs = 30000;  // Maximum wait for the order confirmation by the Orders Stream
+static int streamWaitMs = 1000;  // Maximum wait by the Orders Stream before polling REST
+static int historyConcurrency = 4;
+static std::shared_ptr<ftx::RESTClient> ftxClient;
 static std::unique_ptr<ftx::WSStreamManager> streamManager;
+static std::unique_ptr<ftx::CandleStore> candleStore;
+static const char *CANDLE_STORE_DIR = R"(./Data/FTX)";
 
 enum ExchangeStatus {
     Unavailable = 0,
@@ -46,6 +52,83 @@ __int64 convertTime(DATE Date) {
     return (__int64) ((Date - 25569.) * 24. * 60. * 60.);
 }
 
+/**
+ * Serve candles from the local candle store and download only the missing head and tail ranges. Only closed
+ * candles are stored, the currently forming one is always downloaded.
+ */
+std::vector<ftx::Candle> getCachedHistoricalPrices(const std::string &asset, int resolution, int64_t from, int64_t to) {
+
+    const auto range = candleStore ? candleStore->range(asset, resolution) : std::nullopt;
+
+    if (!candleStore || (range && (from - range->second > to - from || range->first - to > to - from))) {
+        /// Requested range is too far from the stored one, do not fill such a gap just for caching
+        return ftxClient->getHistoricalPrices(asset, resolution, from, to);
+    }
+
+    const auto now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    const int64_t lastClosed = now / resolution * resolution - resolution;
+
+    const auto storeClosed = [&](std::vector<ftx::Candle> &candles) {
+        const auto it = std::find_if(candles.begin(), candles.end(), [&](const ftx::Candle &candle) {
+            return candle.m_startTime / ftx::MICROSECONDS_PER_SECOND > lastClosed;
+        });
+
+        candleStore->append(asset, resolution, std::vector<ftx::Candle>(candles.begin(), it));
+        candles.erase(candles.begin(), it);
+    };
+
+    std::vector<ftx::Candle> unfinished;
+
+    if (!range) {
+        unfinished = ftxClient->getHistoricalPrices(asset, resolution, from, to);
+        storeClosed(unfinished);
+    } else {
+        if (from < range->first) {
+            auto head = ftxClient->getHistoricalPrices(asset, resolution, from, range->first - resolution);
+            storeClosed(head);
+        }
+        if (to > range->second) {
+            unfinished = ftxClient->getHistoricalPrices(asset, resolution, range->second + resolution, to);
+            storeClosed(unfinished);
+        }
+    }
+
+    auto retVal = candleStore->read(asset, resolution, from, to);
+    retVal.insert(retVal.end(), unfinished.begin(), unfinished.end());
+    return retVal;
+}
+
+/**
+ * Serve the most recent candles from bars aggregated from the trades stream and download only the older ones
+ */
+std::vector<ftx::Candle> getHistoricalPrices(const std::string &asset, int resolution, int64_t from, int64_t to) {
+
+    const auto bars = streamManager ? streamManager->readBars(asset, resolution, from, to)
+                                    : std::vector<ftx::Candle>{};
+
+    if (bars.empty()) {
+        return getCachedHistoricalPrices(asset, resolution, from, to);
+    }
+
+    const auto barsStart = bars.front().m_startTime;
+    std::vector<ftx::Candle> retVal;
+
+    if (from <= barsStart / ftx::MICROSECONDS_PER_SECOND - resolution) {
+        retVal = getCachedHistoricalPrices(asset, resolution, from,
+                                           barsStart / ftx::MICROSECONDS_PER_SECOND - resolution);
+
+        const auto it = std::find_if(retVal.begin(), retVal.end(), [&](const ftx::Candle &candle) {
+            return candle.m_startTime >= barsStart;
+        });
+
+        retVal.erase(it, retVal.end());
+    }
+
+    retVal.insert(retVal.end(), bars.begin(), bars.end());
+    return retVal;
+}
+
 DLLFUNC_C int BrokerOpen(char *Name, FARPROC fpError, FARPROC fpProgress) {
     strcpy_s(Name, 32, "FTX");
     (FARPROC &) BrokerError = fpError;
@@ -81,6 +164,7 @@ DLLFUNC_C int BrokerLogin(char *User, char *Pwd, char *Type, char *Account) {
 
     if (!User) {
         streamManager.reset();
+        candleStore.reset();
         ftxClient.reset();
         spdlog::info("Logout");
         spdlog::shutdown();
@@ -97,7 +181,8 @@ DLLFUNC_C int BrokerLogin(char *User, char *Pwd, char *Type, char *Account) {
             spdlog::flush_on(spdlog::level::info);
 
             if (!std::string_view(User).empty() && !std::string_view(Pwd).empty()) {
-                ftxClient = std::make_unique<ftx::RESTClient>(User, Pwd, Account);
+                ftxClient = std::make_shared<ftx::RESTClient>(User, Pwd, Account);
+                ftxClient->setHistoryConcurrency(historyConcurrency);
                 time_t Time;
                 time(&Time);
                 lastOrderId = (int) Time;
@@ -112,14 +197,37 @@ DLLFUNC_C int BrokerLogin(char *User, char *Pwd, char *Type, char *Account) {
             ftxClient->setCredentials(User, Pwd, Account);
         }
 
+        if (!candleStore) {
+            candleStore = std::make_unique<ftx::CandleStore>(CANDLE_STORE_DIR);
+        }
+
         if (!streamManager) {
-            streamManager = std::make_unique<ftx::WSStreamManager>(User, Pwd, Account);
+            streamManager = std::make_unique<ftx::WSStreamManager>(User, Pwd, Account, ftxClient);
             streamManager->setLoggerCallback(&logFunction);
         }
     }
 
     try {
-        const auto account = ftxClient->getAccountInfo();
+        /// Verifies the credentials on the worker pool while the markets are bulk loaded below
+        auto accountFuture = ftxClient->getAccountInfoAsync();
+
+        try {
+            /// Market metadata for BrokerAsset, kept current by the stream
+            streamManager->subscribeMarketsStream();
+        }
+        catch (std::exception &e) {
+            spdlog::warn("Cannot subscribe markets stream, reason: {}", e.what());
+        }
+
+        try {
+            /// Order confirmations for BrokerBuy2, subscribed ahead so that no update of a new order is missed
+            streamManager->subscribeOrdersStream();
+        }
+        catch (std::exception &e) {
+            spdlog::warn("Cannot subscribe orders stream, reason: {}", e.what());
+        }
+
+        const auto account = accountFuture.get();
 
         if (verbose) {
             spdlog::info("Calling BrokerLogin end, user: {}, pswd: {}, type: {}, account: {}", User, Pwd, Type,
@@ -146,29 +254,42 @@ BrokerAsset(char *Asset, double *pPrice, double *pSpread, double *pVolume, doubl
 
     if (pPip != nullptr) {
         try {
-            const auto market = ftxClient->getMarket(Asset);
+            /// Metadata from the market cache and prices from the ticker stream, REST only when either is missing
+            auto market = streamManager->readMarket(Asset);
+            std::optional<ftx::TickerData> tickPrice;
 
-            if (market.m_ask == 0.0 || market.m_bid == 0.0) {
+            if (market) {
+                tickPrice = streamManager->readTickerData(streamManager->subscribeTickerStream(Asset));
+            }
+
+            if (market && tickPrice) {
+                market->m_ask = tickPrice->m_ask;
+                market->m_bid = tickPrice->m_bid;
+            } else {
+                market = ftxClient->getMarket(Asset);
+            }
+
+            if (market->m_ask == 0.0 || market->m_bid == 0.0) {
                 return 0;
             }
 
             if (pPrice) {
-                *pPrice = market.m_ask;
+                *pPrice = market->m_ask;
             }
             if (pSpread) {
-                *pSpread = market.m_ask - market.m_bid;
+                *pSpread = market->m_ask - market->m_bid;
             }
             if (pVolume) {
-                *pVolume = market.m_quoteVolume24h;
+                *pVolume = market->m_quoteVolume24h;
             }
             if (pPip) {
-                *pPip = market.m_sizeIncrement;
+                *pPip = market->m_sizeIncrement;
             }
             if (pLotAmount) {
-                *pLotAmount = market.m_minProvideSize;
+                *pLotAmount = market->m_minProvideSize;
             }
             if (pPipCost) {
-                *pPipCost = market.m_minProvideSize * market.m_sizeIncrement;
+                *pPipCost = market->m_minProvideSize * market->m_sizeIncrement;
             }
             return 1;
         }
@@ -179,9 +300,9 @@ BrokerAsset(char *Asset, double *pPrice, double *pSpread, double *pVolume, doubl
     } else {
         try {
             /// Subscribe stream for Asset - if not already subscribed
-            streamManager->subscribeTickerStream(Asset);
+            const auto tickerIndex = streamManager->subscribeTickerStream(Asset);
 
-            const auto tickPrice = streamManager->readTickerData(Asset);
+            const auto tickPrice = streamManager->readTickerData(tickerIndex);
 
             if (tickPrice) {
 
@@ -280,27 +401,25 @@ DLLFUNC_C int BrokerHistory2(char *Asset, DATE tStart, DATE tEnd, int nTickMinut
         }
 
         int64_t offsetStart = convertTime(tEnd) - nTicks * resolution;
-        auto candles = ftxClient->getHistoricalPrices(Asset, resolution, offsetStart, convertTime(tEnd));
 
-        const auto maxCandles = std::min(nTicks, (int) candles.size());
-        std::reverse(candles.begin(), candles.end());
+        const auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
 
-        /// From most recent to oldest.
-        for (int i = 0; i < maxCandles; i++, ticks++) {
-            ticks->fOpen = static_cast<float>(candles[i].m_open);
-            ticks->fHigh = static_cast<float>(candles[i].m_high);
-            ticks->fLow = static_cast<float>(candles[i].m_low);
-            ticks->fClose = static_cast<float>(candles[i].m_close);
-            ticks->fVol = static_cast<float>(candles[i].m_volume);
-
-            std::tm candleTime{};
-            std::istringstream ss(candles[i].m_startTime);
-            ss >> std::get_time(&candleTime, "%Y-%m-%dT%H:%M:%S:%z");
-            ticks->time = ftx::systemTimeToVariantTimeMs(candleTime.tm_year + 1900, candleTime.tm_mon + 1,
-                                                         candleTime.tm_mday,
-                                                         candleTime.tm_hour, candleTime.tm_min, candleTime.tm_sec, 0);
+        if (streamManager && convertTime(tEnd) >= now - static_cast<int64_t>(ftx::BarBuilder::MAX_BARS) * resolution) {
+            /// Later calls for the same asset are served from the trades stream, downloads of older history reach
+            /// beyond the bar buffer and would only keep the market streaming for nothing
+            streamManager->subscribeTradesStream(Asset);
         }
 
+        auto candles = getHistoricalPrices(Asset, resolution, offsetStart, convertTime(tEnd));
+
+        static_assert(sizeof(T6) == sizeof(ftx::T6Record) && offsetof(T6, fVol) == offsetof(ftx::T6Record, m_vol),
+                      "ftx::T6Record does not match T6");
+
+        /// From most recent to oldest.
+        const auto maxCandles = static_cast<int>(
+                ftx::convertCandlesToT6(candles, nTicks, reinterpret_cast<ftx::T6Record *>(ticks)));
+
         return maxCandles;
     }
     catch (std::exception &e) {
@@ -358,31 +477,62 @@ DLLFUNC_C int BrokerBuy2(char *Asset, int Amount, double dStopDist, double Limit
 
         order.m_clientId = std::to_string(lastOrderId++);
 
+        if (streamManager) {
+            streamManager->subscribeOrdersStream();
+        }
+
         const auto confirmedOrder = ftxClient->placeOrder(order);
 
-        ftx::Order ackOrder;
-        int maxAttempts = 10;
-        int attemptNo = 0;
+        /// Pushed by the Orders Stream, updates received before placeOrder returned are buffered. The wait is bounded
+        /// so that a silent stream (e.g. not subscribed yet) falls back to REST soon, an order resting on the book ends
+        /// the wait at once.
+        const bool immediate = order.m_ioc || order.m_type == +ftx::OrderType::market;
+        const auto orderData = streamManager ? streamManager->readClosedOrderData(
+                confirmedOrder, std::chrono::milliseconds(std::min(waitMs, streamWaitMs)), !immediate)
+                                             : std::nullopt;
 
-        while (ackOrder.m_status != +ftx::OrderStatus::closed) {
+        double avgFillPrice;
+        double filledSize;
 
-            ackOrder = ftxClient->getOrderStatus(stoi(confirmedOrder.m_clientId), true);
-            attemptNo++;
+        if (orderData && orderData->m_status != +ftx::OrderStatus::closed) {
+            spdlog::error("Cannot send order to server, reason: order was not closed/filled");
+            BrokerError("Cannot send order to server.");
+            return 0;
+        } else if (orderData) {
+            avgFillPrice = orderData->m_avgFillPrice;
+            filledSize = orderData->m_filledSize;
+        } else {
+            ftx::Order ackOrder;
+            int maxAttempts = 10;
+            int attemptNo = 0;
 
-            if (attemptNo == maxAttempts) {
-                spdlog::error("Cannot send order to server, reason: order was not closed/filled");
-                BrokerError("Cannot send order to server.");
-                return 0;
+            while (ackOrder.m_status != +ftx::OrderStatus::closed) {
+
+                ackOrder = ftxClient->getOrderStatus(stoi(confirmedOrder.m_clientId), true);
+                attemptNo++;
+
+                if (ackOrder.m_status == +ftx::OrderStatus::closed) {
+                    break;
+                }
+
+                if (attemptNo == maxAttempts) {
+                    spdlog::error("Cannot send order to server, reason: order was not closed/filled");
+                    BrokerError("Cannot send order to server.");
+                    return 0;
+                }
+
+                std::this_thread::sleep_for(500ms);
             }
 
-            std::this_thread::sleep_for(500ms);
+            avgFillPrice = ackOrder.m_avgFillPrice;
+            filledSize = ackOrder.m_filledSize;
         }
 
         if (pPrice) {
-            *pPrice = ackOrder.m_avgFillPrice;
+            *pPrice = avgFillPrice;
         }
         if (pFill) {
-            *pFill = std::round(ackOrder.m_filledSize / lotAmount);
+            *pFill = std::round(filledSize / lotAmount);
         }
         spdlog::info("Order placed for asset: " + std::string(Asset) + ", filled size: " +
                      std::to_string(confirmedOrder.m_filledSize / lotAmount) + ", price" +
@@ -404,6 +554,31 @@ DLLFUNC_C int BrokerBuy2(char *Asset, int Amount, double dStopDist, double Limit
     return 0;
 }
 
+/**
+ * Fill the Zorro quote list from the local order book, bids have negative prices
+ * @return number of quotes written, at most MAX_QUOTES
+ */
+int fillQuotes(const ftx::OrderBook &orderBook, T2 *quotes) {
+    const DATE time = ftx::microsecondsToVariantTime(
+            static_cast<std::int64_t>(orderBook.time() * ftx::MICROSECONDS_PER_SECOND));
+    const auto maxLevels = static_cast<std::size_t>(MAX_QUOTES / 2);
+    int numQuotes = 0;
+
+    for (std::size_t i = 0; i < orderBook.bids().size() && i < maxLevels; i++, numQuotes++) {
+        quotes[numQuotes].time = time;
+        quotes[numQuotes].fVal = -static_cast<float>(orderBook.bids()[i].m_price);
+        quotes[numQuotes].fVol = static_cast<float>(orderBook.bids()[i].m_size);
+    }
+
+    for (std::size_t i = 0; i < orderBook.asks().size() && i < maxLevels; i++, numQuotes++) {
+        quotes[numQuotes].time = time;
+        quotes[numQuotes].fVal = static_cast<float>(orderBook.asks()[i].m_price);
+        quotes[numQuotes].fVol = static_cast<float>(orderBook.asks()[i].m_size);
+    }
+
+    return numQuotes;
+}
+
 DLLFUNC_C double BrokerCommand(int Command, DWORD dwParameter) {
 
     if (verbose) {
@@ -431,8 +606,24 @@ DLLFUNC_C double BrokerCommand(int Command, DWORD dwParameter) {
             if (ftxClient) {
                 const char *symbol = (char *) dwParameter;
                 try {
-                    auto position = ftxClient->getPosition(symbol);
-                    return position.m_openSize;
+                    std::optional<ftx::Position> position;
+
+                    if (streamManager) {
+                        try {
+                            /// Seeds the position book on the first call
+                            streamManager->subscribePositionBook();
+                            position = streamManager->readPosition(symbol);
+                        }
+                        catch (std::exception &e) {
+                            spdlog::warn("Cannot read position book, reason: {}", e.what());
+                        }
+                    }
+
+                    if (!position) {
+                        position = ftxClient->getPosition(symbol);
+                    }
+
+                    return position->m_netSize;
                 }
                 catch (std::exception &e) {
                     const auto msg = std::string("Cannot get position of " + std::string(symbol));
@@ -441,8 +632,26 @@ DLLFUNC_C double BrokerCommand(int Command, DWORD dwParameter) {
                 }
             }
             break;
+        case GET_BOOK:
+            if (streamManager && !currentSymbol.empty() && dwParameter) {
+                try {
+                    /// Subscribe stream for the current symbol - if not already subscribed
+                    streamManager->subscribeOrderBookStream(currentSymbol);
+                    const auto orderBook = streamManager->readOrderBook(currentSymbol);
+
+                    if (orderBook) {
+                        return fillQuotes(*orderBook, (T2 *) dwParameter);
+                    }
+                }
+                catch (std::exception &e) {
+                    const auto msg = std::string("Cannot get order book of " + currentSymbol);
+                    spdlog::error("{}, reason: {}", msg, e.what());
+                    BrokerError(msg.c_str());
+                }
+            }
+            break;
         case GET_MAXREQUESTS:
-            return 10;
+            return ftx::RateLimiter::instance().requestsPerSecond();
         case GET_MAXTICKS:
             return 250;
         case GET_COMPLIANCE:
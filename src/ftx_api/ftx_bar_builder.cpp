@@ -0,0 +1,138 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include <ftx_api/ftx_bar_builder.h>
+#include <ftx_api/utils.h>
+#include <algorithm>
+
+namespace ftx {
+
+static Candle makeBar(std::int64_t startTime, double price, double volume) {
+    Candle bar;
+    bar.m_startTime = startTime;
+    bar.m_open = price;
+    bar.m_high = price;
+    bar.m_low = price;
+    bar.m_close = price;
+    bar.m_volume = volume;
+    return bar;
+}
+
+const Candle &BarBuilder::Series::at(std::size_t i) const {
+    return m_bars[(m_head + i) % m_bars.size()];
+}
+
+Candle &BarBuilder::Series::at(std::size_t i) {
+    return m_bars[(m_head + i) % m_bars.size()];
+}
+
+void BarBuilder::Series::push(const Candle &bar) {
+    if (m_bars.size() < MAX_BARS) {
+        m_bars.push_back(bar);
+    } else {
+        m_bars[m_head] = bar;
+        m_head = (m_head + 1) % MAX_BARS;
+    }
+}
+
+void BarBuilder::add(const Trade &trade) {
+    const auto time = trade.m_time / MICROSECONDS_PER_SECOND;
+    const auto volume = trade.m_price * trade.m_size;
+
+    for (std::size_t r = 0; r < RESOLUTIONS.size(); ++r) {
+        auto &series = m_series[r];
+        const std::int64_t step = RESOLUTIONS[r] * MICROSECONDS_PER_SECOND;
+        const std::int64_t start = time / RESOLUTIONS[r] * step;
+
+        if (series.m_bars.empty()) {
+            series.m_partialStart = start;
+            series.push(makeBar(start, trade.m_price, volume));
+            continue;
+        }
+
+        const auto numBars = series.m_bars.size();
+        const auto &last = series.at(numBars - 1);
+
+        if (start > last.m_startTime) {
+            const auto close = last.m_close;
+
+            /// Intervals without trades, only the ones fitting into the buffer are created
+            for (auto flatStart = std::max(last.m_startTime + step, start - static_cast<std::int64_t>(MAX_BARS) * step);
+                 flatStart < start; flatStart += step) {
+                series.push(makeBar(flatStart, close, 0.0));
+            }
+
+            series.push(makeBar(start, trade.m_price, volume));
+            continue;
+        }
+
+        /// A late trade updates its bar if it is still buffered
+        const auto back = static_cast<std::size_t>((last.m_startTime - start) / step);
+
+        if (back >= numBars) {
+            continue;
+        }
+
+        auto &bar = series.at(numBars - 1 - back);
+        bar.m_high = std::max(bar.m_high, trade.m_price);
+        bar.m_low = std::min(bar.m_low, trade.m_price);
+        bar.m_volume += volume;
+
+        if (back == 0) {
+            bar.m_close = trade.m_price;
+        }
+    }
+}
+
+void BarBuilder::clear() {
+    for (auto &series: m_series) {
+        series = {};
+    }
+}
+
+std::vector<Candle> BarBuilder::read(std::int32_t resolutionInSecs, std::int64_t from, std::int64_t to) const {
+    const auto it = std::find(RESOLUTIONS.begin(), RESOLUTIONS.end(), resolutionInSecs);
+
+    if (it == RESOLUTIONS.end()) {
+        return {};
+    }
+
+    const auto &series = m_series[it - RESOLUTIONS.begin()];
+
+    if (series.m_bars.empty()) {
+        return {};
+    }
+
+    const std::int64_t step = resolutionInSecs * MICROSECONDS_PER_SECOND;
+    const auto now = std::chrono::duration_cast<std::chrono::seconds>(currentTime().time_since_epoch()).count();
+    const auto fromTime = from * MICROSECONDS_PER_SECOND;
+    const auto toTime = std::min(to, now) * MICROSECONDS_PER_SECOND;
+    std::vector<Candle> retVal;
+
+    for (std::size_t i = 0; i < series.m_bars.size(); ++i) {
+        const auto &bar = series.at(i);
+
+        if (bar.m_startTime != series.m_partialStart && bar.m_startTime >= fromTime && bar.m_startTime <= toTime) {
+            retVal.push_back(bar);
+        }
+    }
+
+    const auto &last = series.at(series.m_bars.size() - 1);
+    std::size_t numFlatBars = 0;
+
+    for (auto start = last.m_startTime + step; start <= toTime && numFlatBars < MAX_BARS; start += step) {
+        if (start >= fromTime) {
+            retVal.push_back(makeBar(start, last.m_close, 0.0));
+            numFlatBars++;
+        }
+    }
+
+    return retVal;
+}
+}
@@ -0,0 +1,226 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include <ftx_api/ftx_candle_store.h>
+#include <ftx_api/utils.h>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <map>
+
+namespace ftx {
+
+static const char STORE_MAGIC[4] = {'F', 'T', 'X', 'C'};
+static const std::uint32_t STORE_VERSION = 1;
+static const char *STORE_FILE_EXTENSION = ".ftxc";
+
+#pragma pack(push, 1)
+struct StoreHeader {
+    char m_magic[4];
+    std::uint32_t m_version;
+    std::int32_t m_resolution;
+    std::uint32_t m_recordSize;
+};
+
+struct CandleRecord {
+    std::int64_t m_startTime;
+    double m_open;
+    double m_high;
+    double m_low;
+    double m_close;
+    double m_volume;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(StoreHeader) == 16);
+static_assert(sizeof(CandleRecord) == 48);
+
+struct Series {
+    std::filesystem::path m_path;
+    std::vector<CandleRecord> m_records;
+};
+
+struct CandleStore::P {
+    std::filesystem::path m_directory;
+    mutable std::mutex m_locker;
+    mutable std::map<std::string, Series> m_series;
+
+    static std::string fileName(const std::string &marketName, std::int32_t resolutionInSecs) {
+        std::string retVal = marketName;
+
+        /// Spot markets contain '/', e.g. BTC/USD
+        for (auto &c: retVal) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-') {
+                c = '_';
+            }
+        }
+
+        return retVal + "_" + std::to_string(resolutionInSecs) + STORE_FILE_EXTENSION;
+    }
+
+    static void sortRecords(std::vector<CandleRecord> &records) {
+        std::stable_sort(records.begin(), records.end(), [](const CandleRecord &a, const CandleRecord &b) {
+            return a.m_startTime < b.m_startTime;
+        });
+
+        records.erase(std::unique(records.begin(), records.end(), [](const CandleRecord &a, const CandleRecord &b) {
+            return a.m_startTime == b.m_startTime;
+        }), records.end());
+    }
+
+    static void load(Series &series, std::int32_t resolutionInSecs) {
+        std::error_code ec;
+        const auto fileSize = std::filesystem::file_size(series.m_path, ec);
+
+        if (ec) {
+            return;
+        }
+
+        std::ifstream file(series.m_path, std::ios::binary);
+        StoreHeader header{};
+
+        if (fileSize < sizeof(StoreHeader) || !file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+            std::memcmp(header.m_magic, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0 ||
+            header.m_version != STORE_VERSION || header.m_resolution != resolutionInSecs ||
+            header.m_recordSize != sizeof(CandleRecord)) {
+            /// Unknown or corrupted file, start from scratch
+            file.close();
+            std::filesystem::remove(series.m_path, ec);
+            return;
+        }
+
+        const std::size_t numRecords = (fileSize - sizeof(StoreHeader)) / sizeof(CandleRecord);
+        series.m_records.resize(numRecords);
+        file.read(reinterpret_cast<char *>(series.m_records.data()),
+                  static_cast<std::streamsize>(numRecords * sizeof(CandleRecord)));
+        file.close();
+
+        /// Drop a partially written record left by an interrupted append
+        if (sizeof(StoreHeader) + numRecords * sizeof(CandleRecord) != fileSize) {
+            std::filesystem::resize_file(series.m_path, sizeof(StoreHeader) + numRecords * sizeof(CandleRecord), ec);
+        }
+
+        /// Head ranges are appended after the tail, keep records ordered in memory
+        sortRecords(series.m_records);
+    }
+
+    Series &series(const std::string &marketName, std::int32_t resolutionInSecs) const {
+        const auto name = fileName(marketName, resolutionInSecs);
+        auto it = m_series.find(name);
+
+        if (it == m_series.end()) {
+            Series series;
+            series.m_path = m_directory / name;
+            load(series, resolutionInSecs);
+            it = m_series.emplace(name, std::move(series)).first;
+        }
+
+        return it->second;
+    }
+
+    static std::vector<CandleRecord>::const_iterator
+    lowerBound(const std::vector<CandleRecord> &records, std::int64_t time) {
+        return std::lower_bound(records.begin(), records.end(), time, [](const CandleRecord &r, std::int64_t t) {
+            return r.m_startTime < t;
+        });
+    }
+};
+
+CandleStore::CandleStore(const std::string &directory) : m_p(spimpl::make_unique_impl<P>()) {
+    m_p->m_directory = directory;
+    std::error_code ec;
+    std::filesystem::create_directories(m_p->m_directory, ec);
+}
+
+std::optional<std::pair<std::int64_t, std::int64_t>>
+CandleStore::range(const std::string &marketName, std::int32_t resolutionInSecs) const {
+    std::lock_guard<std::mutex> lk(m_p->m_locker);
+    const auto &series = m_p->series(marketName, resolutionInSecs);
+
+    if (series.m_records.empty()) {
+        return {};
+    }
+
+    return std::make_pair(series.m_records.front().m_startTime, series.m_records.back().m_startTime);
+}
+
+std::vector<Candle>
+CandleStore::read(const std::string &marketName, std::int32_t resolutionInSecs, std::int64_t from,
+                  std::int64_t to) const {
+    std::lock_guard<std::mutex> lk(m_p->m_locker);
+    const auto &records = m_p->series(marketName, resolutionInSecs).m_records;
+    std::vector<Candle> retVal;
+
+    for (auto it = P::lowerBound(records, from); it != records.end() && it->m_startTime <= to; ++it) {
+        Candle candle;
+        candle.m_startTime = it->m_startTime * MICROSECONDS_PER_SECOND;
+        candle.m_open = it->m_open;
+        candle.m_high = it->m_high;
+        candle.m_low = it->m_low;
+        candle.m_close = it->m_close;
+        candle.m_volume = it->m_volume;
+        retVal.push_back(std::move(candle));
+    }
+
+    return retVal;
+}
+
+void CandleStore::append(const std::string &marketName, std::int32_t resolutionInSecs,
+                         const std::vector<Candle> &candles) {
+    std::lock_guard<std::mutex> lk(m_p->m_locker);
+    auto &series = m_p->series(marketName, resolutionInSecs);
+    std::vector<CandleRecord> newRecords;
+
+    for (const auto &candle: candles) {
+        CandleRecord record{};
+        record.m_startTime = candle.m_startTime / MICROSECONDS_PER_SECOND;
+        record.m_open = candle.m_open;
+        record.m_high = candle.m_high;
+        record.m_low = candle.m_low;
+        record.m_close = candle.m_close;
+        record.m_volume = candle.m_volume;
+
+        const auto it = P::lowerBound(series.m_records, record.m_startTime);
+
+        if (it == series.m_records.end() || it->m_startTime != record.m_startTime) {
+            newRecords.push_back(record);
+        }
+    }
+
+    P::sortRecords(newRecords);
+
+    if (newRecords.empty()) {
+        return;
+    }
+
+    const bool isNewFile = !std::filesystem::exists(series.m_path);
+    std::ofstream file(series.m_path, std::ios::binary | std::ios::app);
+
+    if (isNewFile) {
+        StoreHeader header{};
+        std::memcpy(header.m_magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+        header.m_version = STORE_VERSION;
+        header.m_resolution = resolutionInSecs;
+        header.m_recordSize = sizeof(CandleRecord);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+
+    file.write(reinterpret_cast<const char *>(newRecords.data()),
+               static_cast<std::streamsize>(newRecords.size() * sizeof(CandleRecord)));
+
+    if (!file) {
+        throw std::runtime_error(std::format("Cannot write candle store file: {}", series.m_path.string()).c_str());
+    }
+
+    series.m_records.insert(series.m_records.end(), newRecords.begin(), newRecords.end());
+    P::sortRecords(series.m_records);
+}
+}
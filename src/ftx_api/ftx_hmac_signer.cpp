@@ -0,0 +1,110 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include <ftx_api/ftx_hmac_signer.h>
+#include <ftx_api/utils.h>
+#include <openssl/evp.h>
+#include <memory>
+#include <stdexcept>
+
+namespace ftx {
+
+static const std::size_t SHA256_BLOCK_SIZE = 64;
+static const std::size_t SHA256_DIGEST_SIZE = 32;
+
+struct MDContextDeleter {
+    void operator()(EVP_MD_CTX *ctx) const {
+        EVP_MD_CTX_free(ctx);
+    }
+};
+
+using MDContext = std::unique_ptr<EVP_MD_CTX, MDContextDeleter>;
+
+static MDContext createContext() {
+    MDContext ctx(EVP_MD_CTX_new());
+
+    if (!ctx) {
+        throw std::runtime_error("Cannot create digest context");
+    }
+
+    return ctx;
+}
+
+/// Contexts the keyed states are copied into, reused by all signers of the thread
+struct ScratchContexts {
+    MDContext m_inner = createContext();
+    MDContext m_outer = createContext();
+};
+
+struct HMACSigner::P {
+    MDContext m_inner = createContext();
+    MDContext m_outer = createContext();
+};
+
+HMACSigner::HMACSigner(std::string_view secret) : m_p(spimpl::make_unique_impl<P>()) {
+    const EVP_MD *md = EVP_sha256();
+    std::array<unsigned char, SHA256_BLOCK_SIZE> key{};
+
+    /// RFC 2104, keys longer than the block are hashed first
+    if (secret.size() > SHA256_BLOCK_SIZE) {
+        unsigned int length = 0;
+
+        if (!EVP_Digest(secret.data(), secret.size(), key.data(), &length, md, nullptr)) {
+            throw std::runtime_error("Cannot hash HMAC key");
+        }
+    } else {
+        std::copy(secret.begin(), secret.end(), key.begin());
+    }
+
+    std::array<unsigned char, SHA256_BLOCK_SIZE> innerPad{};
+    std::array<unsigned char, SHA256_BLOCK_SIZE> outerPad{};
+
+    for (std::size_t i = 0; i < SHA256_BLOCK_SIZE; i++) {
+        innerPad[i] = key[i] ^ 0x36;
+        outerPad[i] = key[i] ^ 0x5c;
+    }
+
+    if (!EVP_DigestInit_ex(m_p->m_inner.get(), md, nullptr) ||
+        !EVP_DigestUpdate(m_p->m_inner.get(), innerPad.data(), innerPad.size()) ||
+        !EVP_DigestInit_ex(m_p->m_outer.get(), md, nullptr) ||
+        !EVP_DigestUpdate(m_p->m_outer.get(), outerPad.data(), outerPad.size())) {
+        throw std::runtime_error("Cannot initialize HMAC");
+    }
+}
+
+HMACSigner::Signature HMACSigner::sign(std::initializer_list<std::string_view> parts) const {
+    thread_local ScratchContexts scratch;
+
+    std::array<unsigned char, SHA256_DIGEST_SIZE> digest{};
+    unsigned int length = 0;
+    bool ok = EVP_MD_CTX_copy_ex(scratch.m_inner.get(), m_p->m_inner.get());
+
+    for (const auto &part: parts) {
+        ok = ok && EVP_DigestUpdate(scratch.m_inner.get(), part.data(), part.size());
+    }
+
+    ok = ok && EVP_DigestFinal_ex(scratch.m_inner.get(), digest.data(), &length) &&
+         EVP_MD_CTX_copy_ex(scratch.m_outer.get(), m_p->m_outer.get()) &&
+         EVP_DigestUpdate(scratch.m_outer.get(), digest.data(), length) &&
+         EVP_DigestFinal_ex(scratch.m_outer.get(), digest.data(), &length);
+
+    if (!ok) {
+        throw std::runtime_error("Cannot compute HMAC");
+    }
+
+    Signature signature;
+
+    for (std::size_t i = 0; i < digest.size(); i++) {
+        signature[2 * i] = hexMap[(digest[i] & 0xF0) >> 4];
+        signature[2 * i + 1] = hexMap[digest[i] & 0x0F];
+    }
+
+    return signature;
+}
+}
@@ -9,41 +9,133 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 
 #include <ftx_api/ftx_http_session.h>
 #include <ftx_api/utils.h>
-#include <openssl/hmac.h>
+#include <ftx_api/ftx_ssl_context.h>
+#include <ftx_api/ftx_rate_limiter.h>
+#include <ftx_api/ftx_hmac_signer.h>
 #include <boost/asio/ssl.hpp>
 #include <boost/beast/version.hpp>
+#include <mutex>
+#include <condition_variable>
+#include <charconv>
+#include <array>
 
 namespace ftx {
 
 namespace ssl = boost::asio::ssl;
 using tcp = net::ip::tcp;
 
+static const std::size_t DEFAULT_MAX_CONNECTIONS = 4;
+
+/// Idle keep-alive connections older than this are considered stale and are not reused
+static const int IDLE_TIMEOUT_IN_S = 30;
+
+/**
+ * Rate limiter cost of an endpoint, the first matching entry is used. An entry matches when the method is equal
+ * (http::verb::unknown matches any), the target starts with the prefix and contains the infix.
+ */
+struct EndpointCost {
+    http::verb m_method;
+    std::string_view m_prefix;
+    std::string_view m_infix;
+    double m_weight;
+    RequestPriority m_priority;
+};
+
+static const EndpointCost ENDPOINT_COSTS[] = {
+        {http::verb::post,    "/api/orders",         "",         1.0, RequestPriority::order},
+        {http::verb::delete_, "/api/orders",         "",         1.0, RequestPriority::order},
+        {http::verb::get,     "/api/orders/history", "",         2.0, RequestPriority::history},
+        {http::verb::get,     "/api/fills",          "",         2.0, RequestPriority::history},
+        {http::verb::get,     "/api/markets/",       "/candles", 2.0, RequestPriority::history},
+        {http::verb::get,     "/api/markets",        "",         1.0, RequestPriority::marketData},
+        {http::verb::unknown, "/api/",               "",         1.0, RequestPriority::account}
+};
+
+static const EndpointCost &endpointCost(http::verb method, std::string_view target) {
+    for (const auto &cost: ENDPOINT_COSTS) {
+        if ((cost.m_method == http::verb::unknown || cost.m_method == method) && target.starts_with(cost.m_prefix) &&
+            target.find(cost.m_infix) != std::string_view::npos) {
+            return cost;
+        }
+    }
+
+    return ENDPOINT_COSTS[std::size(ENDPOINT_COSTS) - 1];
+}
+
+struct PooledConnection {
+    std::unique_ptr<ssl::stream<tcp::socket>> m_stream;
+    TimePoint m_lastUsed;
+};
+
 struct HTTPSession::P {
 
     net::io_context m_ioc;
     std::string m_uri;
     std::string m_apiKey;
-    std::string m_apiSecret;
+    std::unique_ptr<HMACSigner> m_signer;
     std::string m_subAccountName;
-    const EVP_MD *m_evp_md;
 
-    P() : m_evp_md(EVP_sha256()) {
+    mutable std::mutex m_poolLocker;
+    std::condition_variable m_poolCondition;
+    std::vector<std::unique_ptr<PooledConnection>> m_idleConnections;
+    std::size_t m_numConnections = 0;
+    std::size_t m_maxConnections = DEFAULT_MAX_CONNECTIONS;
+
+    /// Number of requests waiting for a connection per priority, the higher priority is served first
+    std::array<std::size_t, RequestPriority::_size()> m_poolWaiters{};
 
+    ~P() {
+        std::lock_guard<std::mutex> lk(m_poolLocker);
+
+        for (const auto &connection: m_idleConnections) {
+            boost::system::error_code ec;
+            connection->m_stream->next_layer().close(ec);
+        }
     }
 
     http::response<http::string_body> request(http::request<http::string_body> req);
 
     void authenticate(http::request<http::string_body> &req) const;
+
+    std::unique_ptr<PooledConnection> connect();
+
+    static bool isStale(PooledConnection &connection);
+
+    /// @return True if a request of a higher priority is waiting for a connection
+    [[nodiscard]] bool hasPriorPoolWaiters(std::size_t priority) const;
+
+    /**
+     * Take an idle connection from the pool or open a new one, blocks when the pool limit is reached. Waiting
+     * requests are served by priority.
+     * @param priority
+     * @param reused set to true when a pooled connection was returned
+     */
+    std::unique_ptr<PooledConnection> acquireConnection(RequestPriority priority, bool &reused);
+
+    void releaseConnection(std::unique_ptr<PooledConnection> connection);
+
+    void discardConnection(std::unique_ptr<PooledConnection> connection);
 };
 
 HTTPSession::HTTPSession(const std::string &uri, const std::string &apiKey, const std::string &apiSecret,
                          const std::string &subAccountName) : m_p(spimpl::make_unique_impl<P>()) {
     m_p->m_uri = uri;
     m_p->m_apiKey = apiKey;
-    m_p->m_apiSecret = apiSecret;
+    m_p->m_signer = std::make_unique<HMACSigner>(apiSecret);
     m_p->m_subAccountName = subAccountName;
 }
 
+void HTTPSession::setMaxConnections(std::size_t maxConnections) {
+    std::lock_guard<std::mutex> lk(m_p->m_poolLocker);
+    m_p->m_maxConnections = std::max<std::size_t>(maxConnections, 1);
+    m_p->m_poolCondition.notify_all();
+}
+
+std::size_t HTTPSession::maxConnections() const {
+    std::lock_guard<std::mutex> lk(m_p->m_poolLocker);
+    return m_p->m_maxConnections;
+}
+
 http::response<http::string_body> HTTPSession::methodGet(const std::string &target) {
     std::string endpoint = "/api/" + target;
     http::request<http::string_body> req{http::verb::get, endpoint, 11};
@@ -64,74 +156,203 @@ http::response<http::string_body> HTTPSession::methodDelete(const std::string &t
     return m_p->request(req);
 }
 
-http::response<http::string_body> HTTPSession::P::request(
-        http::request<http::string_body> req) {
-    req.set(http::field::host, m_uri.c_str());
-    req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+std::unique_ptr<PooledConnection> HTTPSession::P::connect() {
+    auto connection = std::make_unique<PooledConnection>();
+    auto &sslContextFactory = SSLContextFactory::instance();
+    connection->m_stream = std::make_unique<ssl::stream<tcp::socket>>(m_ioc, sslContextFactory.context());
 
-    ssl::context ctx{ssl::context::sslv23_client};
-    ctx.set_default_verify_paths();
-
-    tcp::resolver resolver{m_ioc};
-    ssl::stream<tcp::socket> stream{m_ioc, ctx};
-
-    /// Set SNI Hostname (many hosts need this to handshake successfully)
-    if (!SSL_set_tlsext_host_name(stream.native_handle(), m_uri.c_str())) {
+    /// Set SNI Hostname and attach a cached TLS session so the handshake can be resumed
+    if (!sslContextFactory.prepareSession(connection->m_stream->native_handle(), m_uri)) {
         boost::system::error_code ec{static_cast<int>(::ERR_get_error()),
                                      net::error::get_ssl_category()};
         throw boost::system::system_error{ec};
     }
 
+    tcp::resolver resolver{m_ioc};
     auto const results = resolver.resolve(m_uri.c_str(), "443");
-    net::connect(stream.next_layer(), results.begin(), results.end());
-    stream.handshake(ssl::stream_base::client);
+    net::connect(connection->m_stream->next_layer(), results.begin(), results.end());
+    connection->m_stream->next_layer().set_option(tcp::no_delay(true));
+    connection->m_stream->handshake(ssl::stream_base::client);
+    connection->m_lastUsed = currentTime();
 
-    authenticate(req);
+    return connection;
+}
 
-    if (req.method() == http::verb::post) {
-        req.set(http::field::content_type, "application/json");
+bool HTTPSession::P::isStale(PooledConnection &connection) {
+
+    if (currentTime() - connection.m_lastUsed > std::chrono::seconds(IDLE_TIMEOUT_IN_S)) {
+        return true;
     }
 
-    http::write(stream, req);
-    boost::beast::flat_buffer buffer;
-    http::response<http::string_body> response;
-    http::read(stream, buffer, response);
+    auto &socket = connection.m_stream->next_layer();
 
+    if (!socket.is_open()) {
+        return true;
+    }
+
+    /// An idle keep-alive socket must not have anything to read, pending bytes mean close_notify or a RST
     boost::system::error_code ec;
-    stream.shutdown(ec);
-    if (ec == boost::asio::error::eof) {
-        /// Rationale:
-        /// http://stackoverflow.com/questions/25587403/boost-asio-ssl-async-shutdown-always-finishes-with-an-error
-        ec.assign(0, ec.category());
+    const auto available = socket.available(ec);
+    return ec || available > 0;
+}
+
+bool HTTPSession::P::hasPriorPoolWaiters(std::size_t priority) const {
+    for (std::size_t i = 0; i < priority; i++) {
+        if (m_poolWaiters[i] != 0) {
+            return true;
+        }
     }
 
-    return response;
+    return false;
 }
 
-void HTTPSession::P::authenticate(http::request<http::string_body> &req) const {
+std::unique_ptr<PooledConnection> HTTPSession::P::acquireConnection(RequestPriority priority, bool &reused) {
+    const auto index = priority._to_index();
+    std::unique_lock<std::mutex> lk(m_poolLocker);
+    std::unique_ptr<PooledConnection> retVal;
+    m_poolWaiters[index]++;
+
+    for (;;) {
+        if (!hasPriorPoolWaiters(index)) {
+            while (!retVal && !m_idleConnections.empty()) {
+                auto connection = std::move(m_idleConnections.back());
+                m_idleConnections.pop_back();
+
+                if (!isStale(*connection)) {
+                    retVal = std::move(connection);
+                    break;
+                }
+
+                boost::system::error_code ec;
+                connection->m_stream->next_layer().close(ec);
+                m_numConnections--;
+            }
+
+            if (retVal || m_numConnections < m_maxConnections) {
+                break;
+            }
+        }
+
+        m_poolCondition.wait(lk);
+    }
+
+    m_poolWaiters[index]--;
+
+    /// Requests of a lower priority may be waiting behind this one
+    m_poolCondition.notify_all();
+
+    if (retVal) {
+        reused = true;
+        return retVal;
+    }
+
+    m_numConnections++;
+    lk.unlock();
+
+    try {
+        reused = false;
+        return connect();
+    }
+    catch (...) {
+        lk.lock();
+        m_numConnections--;
+        m_poolCondition.notify_all();
+        throw;
+    }
+}
+
+void HTTPSession::P::releaseConnection(std::unique_ptr<PooledConnection> connection) {
+    connection->m_lastUsed = currentTime();
+
+    std::lock_guard<std::mutex> lk(m_poolLocker);
 
-    std::string method(req.method_string());
-    std::string path(req.target());
-    std::string body(req.body());
+    if (m_numConnections > m_maxConnections) {
+        boost::system::error_code ec;
+        connection->m_stream->next_layer().close(ec);
+        m_numConnections--;
+    } else {
+        m_idleConnections.push_back(std::move(connection));
+    }
 
-    auto ts = getMsTimestamp(currentTime()).count();
-    std::string data = std::to_string(ts) + method + path;
+    /// Waiters of various priorities may be waiting, the first one in order takes the connection
+    m_poolCondition.notify_all();
+}
 
-    if (!body.empty()) {
-        data += body;
+void HTTPSession::P::discardConnection(std::unique_ptr<PooledConnection> connection) {
+    boost::system::error_code ec;
+    connection->m_stream->next_layer().close(ec);
+
+    std::lock_guard<std::mutex> lk(m_poolLocker);
+    m_numConnections--;
+    m_poolCondition.notify_all();
+}
+
+http::response<http::string_body> HTTPSession::P::request(
+        http::request<http::string_body> req) {
+    req.set(http::field::host, m_uri.c_str());
+    req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+    req.keep_alive(true);
+
+    if (req.method() == http::verb::post) {
+        req.set(http::field::content_type, "application/json");
     }
 
-    unsigned char digest[SHA256_DIGEST_LENGTH];
-    unsigned int digestLength = 32;
+    const auto &cost = endpointCost(req.method(), {req.target().data(), req.target().size()});
+    bool retried = false;
+
+    for (;;) {
+        /// Each attempt is sent separately so it takes its own token. Sign after both waits, the timestamp must not
+        /// age in the queues.
+        RateLimiter::instance().acquire(cost.m_weight, cost.m_priority);
+
+        bool reused = false;
+        bool written = false;
+        auto connection = acquireConnection(cost.m_priority, reused);
+        authenticate(req);
+
+        try {
+            http::write(*connection->m_stream, req);
+            written = true;
+            boost::beast::flat_buffer buffer;
+            http::response<http::string_body> response;
+            http::read(*connection->m_stream, buffer, response);
+
+            if (response.keep_alive()) {
+                releaseConnection(std::move(connection));
+            } else {
+                discardConnection(std::move(connection));
+            }
+
+            return response;
+        }
+        catch (const boost::system::system_error &) {
+            discardConnection(std::move(connection));
+
+            /// Server may close a keep-alive connection at any time, retry once with a fresh one. A POST which was
+            /// written completely may have been executed already (e.g. an order placed), it must not be sent twice.
+            if (!reused || retried || (written && req.method() == http::verb::post)) {
+                throw;
+            }
+
+            retried = true;
+        }
+    }
+}
+
+void HTTPSession::P::authenticate(http::request<http::string_body> &req) const {
 
-    HMAC(m_evp_md, m_apiSecret.data(), m_apiSecret.size(), reinterpret_cast<const unsigned char *>(data.data()),
-         data.length(), digest, &digestLength);
+    char ts[20];
+    const auto tsEnd = std::to_chars(std::begin(ts), std::end(ts), getMsTimestamp(currentTime()).count()).ptr;
+    const std::string_view tsView(ts, tsEnd - ts);
+    const auto method = req.method_string();
+    const auto path = req.target();
 
-    std::string sign = stringToHex(digest, sizeof(digest));
+    const auto sign = m_signer->sign({tsView, {method.data(), method.size()}, {path.data(), path.size()},
+                                      req.body()});
 
     req.set("FTX-KEY", m_apiKey);
-    req.set("FTX-TS", std::to_string(ts));
-    req.set("FTX-SIGN", sign);
+    req.set("FTX-TS", beast::string_view(tsView.data(), tsView.size()));
+    req.set("FTX-SIGN", beast::string_view(sign.data(), sign.size()));
 
     if (!m_subAccountName.empty()) {
         req.set("FTX-SUBACCOUNT", m_subAccountName);
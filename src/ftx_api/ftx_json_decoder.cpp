@@ -0,0 +1,185 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include <ftx_api/ftx_json_decoder.h>
+
+namespace ftx {
+
+static bool decodeValue(JsonReader &reader, Positions &value) {
+    return readJsonValue(reader, value.m_positions);
+}
+
+static bool decodeValue(JsonReader &reader, Candles &value) {
+    return readJsonValue(reader, value.m_candles);
+}
+
+static bool decodeValue(JsonReader &reader, Fills &value) {
+    return readJsonValue(reader, value.m_fills);
+}
+
+static bool decodeValue(JsonReader &reader, Orders &value) {
+    return readJsonValue(reader, value.m_orders);
+}
+
+static bool decodeValue(JsonReader &reader, Markets &value) {
+    return readJsonValue(reader, value.m_markets);
+}
+
+template<typename ValueType> requires HasJsonFields<ValueType>
+static bool decodeValue(JsonReader &reader, ValueType &value) {
+    return readJsonFields(reader, value);
+}
+
+template<typename ValueType>
+bool decodeJson(std::string_view buffer, ValueType &value) {
+    JsonReader reader(buffer);
+    return decodeValue(reader, value);
+}
+
+template<typename ValueType>
+bool decodeResponse(std::string_view buffer, bool &success, std::string &error, ValueType &value) {
+    JsonReader reader(buffer);
+    std::string_view key;
+    success = false;
+
+    if (!reader.beginObject()) {
+        return false;
+    }
+
+    while (reader.nextKey(key)) {
+        bool ok;
+
+        if (key == "success") {
+            ok = reader.readBool(success);
+        } else if (key == "error") {
+            ok = reader.readString(error);
+        } else if (key == "result") {
+            ok = reader.readNull() || decodeValue(reader, value);
+        } else {
+            ok = reader.skipValue();
+        }
+
+        if (!ok) {
+            return false;
+        }
+    }
+
+    return !reader.failed();
+}
+
+#define FTX_INSTANTIATE_DECODER(ValueType) \
+    template bool decodeJson<ValueType>(std::string_view buffer, ValueType &value); \
+    template bool decodeResponse<ValueType>(std::string_view buffer, bool &success, std::string &error, \
+                                            ValueType &value);
+
+FTX_INSTANTIATE_DECODER(TickerData)
+FTX_INSTANTIATE_DECODER(Order)
+FTX_INSTANTIATE_DECODER(OrderData)
+FTX_INSTANTIATE_DECODER(FillData)
+FTX_INSTANTIATE_DECODER(Candle)
+FTX_INSTANTIATE_DECODER(Account)
+FTX_INSTANTIATE_DECODER(Position)
+FTX_INSTANTIATE_DECODER(Positions)
+FTX_INSTANTIATE_DECODER(Candles)
+FTX_INSTANTIATE_DECODER(Fills)
+FTX_INSTANTIATE_DECODER(Orders)
+FTX_INSTANTIATE_DECODER(Markets)
+FTX_INSTANTIATE_DECODER(Market)
+FTX_INSTANTIATE_DECODER(ChannelSubscriptionResponse)
+FTX_INSTANTIATE_DECODER(OrderBookData)
+
+#undef FTX_INSTANTIATE_DECODER
+
+bool decodeEvent(std::string_view buffer, Event &event) {
+    using Table = JsonFieldTable<ChannelSubscriptionResponse>;
+    JsonReader reader(buffer);
+    std::string_view key;
+    bool hasChannel = false;
+    auto &response = event.m_subscriptionResponse;
+
+    if (!reader.beginObject()) {
+        return false;
+    }
+
+    while (reader.nextKey(key)) {
+        bool ok;
+
+        if (key == "data") {
+            if (!hasChannel) {
+                return false;
+            }
+
+            switch (response.m_channel) {
+                case Channel::ticker:
+                    ok = readJsonFields(reader, event.m_eventData.emplace<TickerData>());
+                    break;
+                case Channel::orderbook:
+                    ok = readJsonFields(reader, event.m_eventData.emplace<OrderBookData>());
+                    break;
+                case Channel::trades:
+                    ok = readJsonValue(reader, event.m_eventData.emplace<TradesData>().m_trades);
+                    break;
+                case Channel::markets:
+                    ok = readJsonFields(reader, event.m_eventData.emplace<MarketsData>());
+                    break;
+                case Channel::fills:
+                    ok = readJsonFields(reader, event.m_eventData.emplace<FillData>());
+                    break;
+                case Channel::orders:
+                    ok = readJsonFields(reader, event.m_eventData.emplace<OrderData>());
+                    break;
+                default:
+                    return false;
+            }
+        } else if (const auto index = Table::hash.find(key); index >= 0) {
+            ok = Table::streamReaders[index](reader, response);
+            hasChannel = hasChannel || key == "channel";
+        } else {
+            ok = reader.skipValue();
+        }
+
+        if (!ok) {
+            return false;
+        }
+    }
+
+    return !reader.failed();
+}
+
+bool decodeEventHeader(std::string_view buffer, std::string_view &type, std::string_view &channel,
+                       std::string_view &market) {
+    JsonReader reader(buffer);
+    std::string_view key;
+    type = channel = market = {};
+
+    if (!reader.beginObject()) {
+        return false;
+    }
+
+    while (reader.nextKey(key)) {
+        bool ok;
+
+        if (key == "type") {
+            ok = reader.readStringView(type);
+        } else if (key == "channel") {
+            ok = reader.readStringView(channel);
+        } else if (key == "market") {
+            ok = reader.readStringView(market);
+        } else {
+            ok = reader.skipValue();
+        }
+
+        if (!ok) {
+            return false;
+        }
+    }
+
+    return !reader.failed();
+}
+}
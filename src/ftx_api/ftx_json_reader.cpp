@@ -0,0 +1,461 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include <ftx_api/ftx_json_reader.h>
+#include <charconv>
+#include <cctype>
+#include <cstring>
+
+namespace ftx {
+
+JsonReader::JsonReader(std::string_view buffer) : m_pos(buffer.data()), m_end(buffer.data() + buffer.size()) {
+}
+
+void JsonReader::skipWhitespace() {
+    while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) {
+        ++m_pos;
+    }
+}
+
+bool JsonReader::fail() {
+    m_failed = true;
+    return false;
+}
+
+bool JsonReader::consume(char c) {
+    skipWhitespace();
+
+    if (m_failed || m_pos >= m_end || *m_pos != c) {
+        return false;
+    }
+
+    ++m_pos;
+    return true;
+}
+
+bool JsonReader::readRawString(std::string_view &value) {
+    if (!consume('"')) {
+        return fail();
+    }
+
+    const char *begin = m_pos;
+
+    while (m_pos < m_end && *m_pos != '"') {
+        if (*m_pos == '\\') {
+            ++m_pos;
+        }
+
+        ++m_pos;
+    }
+
+    if (m_pos >= m_end) {
+        return fail();
+    }
+
+    value = std::string_view(begin, m_pos - begin);
+    ++m_pos;
+    return true;
+}
+
+bool JsonReader::readNumberToken(std::string_view &value) {
+    skipWhitespace();
+    const char *begin = m_pos;
+
+    while (m_pos < m_end && (std::isdigit(static_cast<unsigned char>(*m_pos)) || *m_pos == '-' || *m_pos == '+' ||
+                             *m_pos == '.' || *m_pos == 'e' || *m_pos == 'E')) {
+        ++m_pos;
+    }
+
+    if (m_pos == begin) {
+        return fail();
+    }
+
+    value = std::string_view(begin, m_pos - begin);
+    return true;
+}
+
+bool JsonReader::beginObject() {
+    skipWhitespace();
+
+    if (m_failed || m_pos >= m_end || *m_pos != '{') {
+        return fail();
+    }
+
+    const char *bracket = m_pos++;
+    skipWhitespace();
+
+    /// Stay on the opening brace (or on the closing one of an empty object), nextKey consumes it
+    if (m_pos < m_end && *m_pos == '}') {
+        return true;
+    }
+
+    m_pos = bracket;
+    return true;
+}
+
+bool JsonReader::nextKey(std::string_view &key) {
+    if (m_failed) {
+        return false;
+    }
+
+    skipWhitespace();
+
+    if (m_pos >= m_end) {
+        return fail();
+    }
+
+    /// Either the opening brace (put back by beginObject) or a comma precedes the key
+    if (*m_pos == '}') {
+        ++m_pos;
+        return false;
+    }
+
+    if (*m_pos != ',' && *m_pos != '{') {
+        return fail();
+    }
+
+    ++m_pos;
+
+    if (!readRawString(key) || !consume(':')) {
+        return fail();
+    }
+
+    return true;
+}
+
+bool JsonReader::beginArray() {
+    skipWhitespace();
+
+    if (m_failed || m_pos >= m_end || *m_pos != '[') {
+        return fail();
+    }
+
+    const char *bracket = m_pos++;
+    skipWhitespace();
+
+    if (m_pos < m_end && *m_pos == ']') {
+        return true;
+    }
+
+    m_pos = bracket;
+    return true;
+}
+
+bool JsonReader::nextElement() {
+    if (m_failed) {
+        return false;
+    }
+
+    skipWhitespace();
+
+    if (m_pos >= m_end) {
+        return fail();
+    }
+
+    if (*m_pos == ']') {
+        ++m_pos;
+        return false;
+    }
+
+    if (*m_pos != ',' && *m_pos != '[') {
+        return fail();
+    }
+
+    ++m_pos;
+    return true;
+}
+
+bool JsonReader::readNull() {
+    skipWhitespace();
+
+    if (m_end - m_pos >= 4 && std::memcmp(m_pos, "null", 4) == 0) {
+        m_pos += 4;
+        return true;
+    }
+
+    return false;
+}
+
+bool JsonReader::readDouble(double &value) {
+    if (m_failed) {
+        return false;
+    }
+
+    if (readNull()) {
+        return true;
+    }
+
+    std::string_view token;
+
+    if (m_pos < m_end && *m_pos == '"') {
+        /// Numeric string, an unparsable one gives 0.0 like readStringAsDouble
+        if (!readRawString(token)) {
+            return false;
+        }
+
+        if (std::from_chars(token.data(), token.data() + token.size(), value).ec != std::errc{}) {
+            value = 0.0;
+        }
+
+        return true;
+    }
+
+    if (!readNumberToken(token)) {
+        return false;
+    }
+
+    if (std::from_chars(token.data(), token.data() + token.size(), value).ec != std::errc{}) {
+        return fail();
+    }
+
+    return true;
+}
+
+bool JsonReader::readNumber(double &value, std::string_view &text) {
+    if (m_failed || !readNumberToken(text)) {
+        return false;
+    }
+
+    if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc{}) {
+        return fail();
+    }
+
+    return true;
+}
+
+bool JsonReader::readInt64(std::int64_t &value) {
+    if (m_failed) {
+        return false;
+    }
+
+    if (readNull()) {
+        return true;
+    }
+
+    std::string_view token;
+
+    if (!readNumberToken(token)) {
+        return false;
+    }
+
+    const auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+
+    if (result.ec != std::errc{}) {
+        return fail();
+    }
+
+    if (result.ptr != token.data() + token.size()) {
+        /// Fractional number, e.g. ticker time in seconds
+        double number;
+
+        if (std::from_chars(token.data(), token.data() + token.size(), number).ec != std::errc{}) {
+            return fail();
+        }
+
+        value = static_cast<std::int64_t>(number);
+    }
+
+    return true;
+}
+
+bool JsonReader::readBool(bool &value) {
+    if (m_failed) {
+        return false;
+    }
+
+    if (readNull()) {
+        return true;
+    }
+
+    if (m_end - m_pos >= 4 && std::memcmp(m_pos, "true", 4) == 0) {
+        m_pos += 4;
+        value = true;
+        return true;
+    }
+
+    if (m_end - m_pos >= 5 && std::memcmp(m_pos, "false", 5) == 0) {
+        m_pos += 5;
+        value = false;
+        return true;
+    }
+
+    return fail();
+}
+
+/// Append a code point encoded as UTF-8
+static void appendUtf8(std::string &value, std::uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        value.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        value.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        value.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        value.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        value.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        value.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        value.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+static bool readHex4(const char *ptr, std::uint32_t &value) {
+    return std::from_chars(ptr, ptr + 4, value, 16).ptr == ptr + 4;
+}
+
+bool JsonReader::readString(std::string &value) {
+    if (m_failed) {
+        return false;
+    }
+
+    if (readNull()) {
+        return true;
+    }
+
+    std::string_view raw;
+
+    if (!readRawString(raw)) {
+        return false;
+    }
+
+    if (raw.find('\\') == std::string_view::npos) {
+        value.assign(raw);
+        return true;
+    }
+
+    value.clear();
+
+    for (std::size_t i = 0; i < raw.size(); ++i) {
+        if (raw[i] != '\\') {
+            value.push_back(raw[i]);
+            continue;
+        }
+
+        if (++i >= raw.size()) {
+            return fail();
+        }
+
+        switch (raw[i]) {
+            case 'b':
+                value.push_back('\b');
+                break;
+            case 'f':
+                value.push_back('\f');
+                break;
+            case 'n':
+                value.push_back('\n');
+                break;
+            case 'r':
+                value.push_back('\r');
+                break;
+            case 't':
+                value.push_back('\t');
+                break;
+            case 'u': {
+                std::uint32_t codePoint = 0;
+
+                if (i + 4 >= raw.size() || !readHex4(raw.data() + i + 1, codePoint)) {
+                    return fail();
+                }
+
+                i += 4;
+
+                /// Surrogate pair
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF && i + 6 < raw.size() && raw[i + 1] == '\\' &&
+                    raw[i + 2] == 'u') {
+                    std::uint32_t low = 0;
+
+                    if (readHex4(raw.data() + i + 3, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                }
+
+                appendUtf8(value, codePoint);
+                break;
+            }
+            default:
+                value.push_back(raw[i]);
+                break;
+        }
+    }
+
+    return true;
+}
+
+bool JsonReader::readStringView(std::string_view &value) {
+    if (m_failed) {
+        return false;
+    }
+
+    if (readNull()) {
+        return true;
+    }
+
+    return readRawString(value);
+}
+
+bool JsonReader::skipValue() {
+    if (m_failed) {
+        return false;
+    }
+
+    skipWhitespace();
+
+    if (m_pos >= m_end) {
+        return fail();
+    }
+
+    std::string_view token;
+
+    switch (*m_pos) {
+        case '"':
+            return readRawString(token);
+        case '{':
+        case '[': {
+            int depth = 0;
+
+            while (m_pos < m_end) {
+                const char c = *m_pos;
+
+                if (c == '"') {
+                    if (!readRawString(token)) {
+                        return false;
+                    }
+                    continue;
+                }
+
+                ++m_pos;
+
+                if (c == '{' || c == '[') {
+                    ++depth;
+                } else if ((c == '}' || c == ']') && --depth == 0) {
+                    return true;
+                }
+            }
+
+            return fail();
+        }
+        case 't': {
+            bool b;
+            return readBool(b);
+        }
+        case 'f': {
+            bool b;
+            return readBool(b);
+        }
+        case 'n':
+            return readNull() || fail();
+        default:
+            return readNumberToken(token);
+    }
+}
+}
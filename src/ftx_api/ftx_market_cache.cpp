@@ -0,0 +1,74 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include <ftx_api/ftx_market_cache.h>
+#include <mutex>
+
+namespace ftx {
+
+/// The markets channel sends metadata without prices and volumes, keep the rest of the REST snapshot
+static void mergeMetadata(Market &market, const Market &update) {
+    market.m_baseCurrency = update.m_baseCurrency;
+    market.m_quoteCurrency = update.m_quoteCurrency;
+    market.m_highLeverageFeeExempt = update.m_highLeverageFeeExempt;
+    market.m_type = update.m_type;
+    market.m_underlying = update.m_underlying;
+    market.m_enabled = update.m_enabled;
+    market.m_postOnly = update.m_postOnly;
+    market.m_priceIncrement = update.m_priceIncrement;
+    market.m_sizeIncrement = update.m_sizeIncrement;
+    market.m_restricted = update.m_restricted;
+
+    if (update.m_minProvideSize != 0.0) {
+        market.m_minProvideSize = update.m_minProvideSize;
+    }
+}
+
+void MarketCache::load(const std::vector<Market> &markets) {
+    std::unordered_map<std::string, Market> cache;
+    cache.reserve(markets.size());
+
+    for (const auto &market: markets) {
+        cache.insert_or_assign(market.m_name, market);
+    }
+
+    std::unique_lock<std::shared_mutex> lk(m_locker);
+    m_markets = std::move(cache);
+}
+
+void MarketCache::update(const MarketsData &data) {
+    std::unique_lock<std::shared_mutex> lk(m_locker);
+
+    for (const auto &market: data.m_markets) {
+        const auto it = m_markets.find(market.m_name);
+
+        if (it == m_markets.end()) {
+            m_markets.emplace(market.m_name, market);
+        } else {
+            mergeMetadata(it->second, market);
+        }
+    }
+}
+
+std::optional<Market> MarketCache::find(const std::string &name) const {
+    std::shared_lock<std::shared_mutex> lk(m_locker);
+    const auto it = m_markets.find(name);
+
+    if (it == m_markets.end()) {
+        return {};
+    }
+
+    return it->second;
+}
+
+std::size_t MarketCache::size() const {
+    std::shared_lock<std::shared_mutex> lk(m_locker);
+    return m_markets.size();
+}
+}
@@ -13,7 +13,16 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 namespace ftx {
 
 nlohmann::json Response::toJson() const {
-    throw std::exception("Unimplemented: Response::toJson()");
+    nlohmann::json json;
+    json["success"] = m_success;
+
+    if (m_success) {
+        json["result"] = m_result;
+    } else {
+        json["error"] = m_error;
+    }
+
+    return json;
 }
 
 void Response::fromJson(const nlohmann::json &json) {
@@ -28,76 +37,30 @@ void Response::fromJson(const nlohmann::json &json) {
 }
 
 nlohmann::json Position::toJson() const {
-    throw std::exception("Unimplemented: Position::toJson()");
+    return toJsonFields(*this);
 }
 
 void Position::fromJson(const nlohmann::json &json) {
-
-    readValue<double>(json, "cost", m_cost);
-    readValue<double>(json, "entryPrice", m_entryPrice);
-    readValue<std::string>(json, "future", m_future);
-    readValue<double>(json, "initialMarginRequirement", m_initialMarginRequirement);
-    readValue<double>(json, "longOrderSize", m_longOrderSize);
-    readValue<double>(json, "maintenanceMarginRequirement", m_maintenanceMarginRequirement);
-    readValue<double>(json, "netSize", m_netSize);
-    readValue<double>(json, "openSize", m_openSize);
-    readValue<double>(json, "realizedPnl", m_realizedPnl);
-    readValue<double>(json, "shortOrderSize", m_shortOrderSize);
-    readEnum<Side>(json, "side", m_side);
-    readValue<double>(json, "size", m_size);
-    readValue<double>(json, "unrealizedPnl", m_unrealizedPnl);
-    readValue<double>(json, "cumulativeBuySize", m_cumulativeBuySize);
-    readValue<double>(json, "cumulativeSellSize", m_cumulativeSellSize);
-    readValue<double>(json, "estimatedLiquidationPrice", m_estimatedLiquidationPrice);
-    readValue<double>(json, "recentAverageOpenPrice", m_recentAverageOpenPrice);
-    readValue<double>(json, "recentBreakEvenPrice", m_recentBreakEvenPrice);
-    readValue<double>(json, "recentPnl", m_recentPnl);
-    readValue<double>(json, "collateralUsed", m_collateralUsed);
+    fromJsonFields(json, *this);
 }
 
 nlohmann::json Positions::toJson() const {
-    throw std::exception("Unimplemented: Positions::toJson()");
+    return toJsonValue(m_positions);
 }
 
 void Positions::fromJson(const nlohmann::json &json) {
-    m_positions.clear();
-
-    for (const auto &el: json) {
-        Position market;
-        market.fromJson(el);
-        m_positions.push_back(market);
-    }
+    fromJsonValue(json, m_positions);
 }
 
 nlohmann::json Account::toJson() const {
-    throw std::exception("Unimplemented: Account::toJson()");
+    return toJsonFields(*this);
 }
 
 void Account::fromJson(const nlohmann::json &json) {
-
-    m_positions.clear();
-    readValue<bool>(json, "backstopProvider", m_backstopProvider);
-    readValue<double>(json, "collateral", m_collateral);
-    readValue<double>(json, "freeCollateral", m_freeCollateral);
-    readValue<double>(json, "initialMarginRequirement", m_initialMarginRequirement);
-    readValue<double>(json, "leverage", m_leverage);
-    readValue<bool>(json, "liquidating", m_liquidating);
-    readValue<double>(json, "maintenanceMarginRequirement", m_maintenanceMarginRequirement);
-    readValue<double>(json, "makerFee", m_makerFee);
-    readValue<double>(json, "marginFraction", m_marginFraction);
-    readValue<double>(json, "openMarginFraction", m_openMarginFraction);
-    readValue<double>(json, "takerFee", m_takerFee);
-    readValue<double>(json, "totalAccountValue", m_totalAccountValue);
-    readValue<double>(json, "totalPositionSize", m_totalPositionSize);
-    readValue<std::string>(json, "username", m_userName);
-
-    for (const auto &el: json["positions"]) {
-        Position ftxPosition;
-        ftxPosition.fromJson(el);
-        m_positions.push_back(ftxPosition);
-    }
+    fromJsonFields(json, *this);
 }
 
+/// Order placement request, only the attributes accepted by POST /orders are written
 nlohmann::json Order::toJson() const {
     nlohmann::json json;
     json["market"] = m_market;
@@ -120,127 +83,62 @@ nlohmann::json Order::toJson() const {
 }
 
 void Order::fromJson(const nlohmann::json &json) {
-    readValue<std::string>(json, "createdAt", m_createdAt);
-    readValue<double>(json, "filledSize", m_filledSize);
-    readValue<std::string>(json, "future", m_future);
-    readValue<std::int64_t>(json, "id", m_id);
-    readValue<std::string>(json, "market", m_market);
-    readValue<double>(json, "price", m_price);
-    readValue<double>(json, "avgFillPrice", m_avgFillPrice);
-    readValue<double>(json, "remainingSize", m_remainingSize);
-    readEnum<Side>(json, "side", m_side);
-    readValue<double>(json, "size", m_size);
-    readEnum<OrderStatus>(json, "status", m_status);
-    readEnum<OrderType>(json, "type", m_type);
-    readValue<bool>(json, "reduceOnly", m_reduceOnly);
-    readValue<bool>(json, "ioc", m_ioc);
-    readValue<bool>(json, "postOnly", m_postOnly);
-    readValue<std::string>(json, "clientId", m_clientId);
-    readValue<double>(json, "trailValue", m_trailValue);
-    readValue<double>(json, "triggerPrice", m_triggerPrice);
+    fromJsonFields(json, *this);
 }
 
 nlohmann::json Market::toJson() const {
-    throw std::exception("Unimplemented: Market::toJson()");
+    return toJsonFields(*this);
 }
 
 void Market::fromJson(const nlohmann::json &json) {
-    readValue<std::string>(json, "name", m_name);
-    readValue<std::string>(json, "baseCurrency", m_baseCurrency);
-    readValue<std::string>(json, "quoteCurrency", m_quoteCurrency);
-    readValue<double>(json, "quoteVolume24h", m_quoteVolume24h);
-    readValue<double>(json, "change1h", m_change1h);
-    readValue<double>(json, "change24h", m_change24h);
-    readValue<double>(json, "changeBod", m_changeBod);
-    readValue<bool>(json, "highLeverageFeeExempt", m_highLeverageFeeExempt);
-    readValue<double>(json, "minProvideSize", m_minProvideSize);
-    readEnum<MarketType>(json, "type", m_type);
-    readValue<std::string>(json, "underlying", m_underlying);
-    readValue<bool>(json, "enabled", m_enabled);
-    readValue<double>(json, "ask", m_ask);
-    readValue<double>(json, "bid", m_bid);
-    readValue<double>(json, "last", m_last);
-    readValue<bool>(json, "postOnly", m_postOnly);
-    readValue<double>(json, "price", m_price);
-    readValue<double>(json, "priceIncrement", m_priceIncrement);
-    readValue<double>(json, "sizeIncrement", m_sizeIncrement);
-    readValue<bool>(json, "restricted", m_restricted);
-    readValue<double>(json, "volumeUsd24h", m_volumeUsd24h);
+    fromJsonFields(json, *this);
 }
 
 nlohmann::json Markets::toJson() const {
-    throw std::exception("Unimplemented: Markets::toJson()");
+    return toJsonValue(m_markets);
 }
 
 void Markets::fromJson(const nlohmann::json &json) {
-
-    m_markets.clear();
-
-    for (const auto &el: json) {
-        Market market;
-        market.fromJson(el);
-        m_markets.push_back(market);
-    }
+    fromJsonValue(json, m_markets);
 }
 
 nlohmann::json Candle::toJson() const {
-    throw std::exception("Unimplemented: Candle::toJson()");
+    return toJsonFields(*this);
 }
 
 void Candle::fromJson(const nlohmann::json &json) {
-    readValue<double>(json, "open", m_open);
-    readValue<double>(json, "high", m_high);
-    readValue<double>(json, "low", m_low);
-    readValue<double>(json, "close", m_close);
-    readValue<double>(json, "volume", m_volume);
-    readValue<std::string>(json, "startTime", m_startTime);
+    fromJsonFields(json, *this);
 }
 
 nlohmann::json Candles::toJson() const {
-    throw std::exception("Unimplemented: Candles::toJson()");
+    return toJsonValue(m_candles);
 }
 
 void Candles::fromJson(const nlohmann::json &json) {
-    m_candles.clear();
-
-    for (const auto &el: json) {
-        Candle candle;
-        candle.fromJson(el);
-        m_candles.push_back(candle);
-    }
+    fromJsonValue(json, m_candles);
 }
 
+/// Channels not bound to a market (e.g. orders) are subscribed without the "market" attribute
 nlohmann::json ChannelSubscriptionRequest::toJson() const {
-    nlohmann::json json;
-    json["op"] = m_op._to_string();
-    json["channel"] = m_channel._to_string();
+    auto json = toJsonFields(*this);
 
-    if (!m_market.empty()) {
-        json["market"] = m_market;
+    if (m_market.empty()) {
+        json.erase("market");
     }
+
     return json;
 }
 
 void ChannelSubscriptionRequest::fromJson(const nlohmann::json &json) {
-    throw std::exception("Unimplemented: ChannelSubscriptionRequest::fromJson()");
+    fromJsonFields(json, *this);
 }
 
 nlohmann::json ChannelSubscriptionResponse::toJson() const {
-    nlohmann::json json;
-    json["type"] = m_type._to_string();
-    json["channel"] = m_channel._to_string();
-    json["market"] = m_market;
-    json["code"] = m_code;
-    json["msg"] = m_msg;
-    return json;
+    return toJsonFields(*this);
 }
 
 void ChannelSubscriptionResponse::fromJson(const nlohmann::json &json) {
-    readEnum<OperationResponse>(json, "type", m_type);
-    readEnum<Channel>(json, "channel", m_channel);
-    readValue<std::string>(json, "market", m_market);
-    readValue<int>(json, "code", m_code);
-    readValue<std::string>(json, "msg", m_msg);
+    fromJsonFields(json, *this);
 }
 
 nlohmann::json AuthenticationRequest::toJson() const {
@@ -255,105 +153,88 @@ nlohmann::json AuthenticationRequest::toJson() const {
     return json;
 }
 
+/// Credentials are nested in "args", the field tables describe flat objects only
 void AuthenticationRequest::fromJson(const nlohmann::json &json) {
-    throw std::exception("Unimplemented: AuthenticationRequest::fromJson()");
+    readEnum<Operation>(json, "op", m_op);
+
+    if (const auto it = json.find("args"); it != json.end() && it->is_object()) {
+        readValue<std::string>(*it, "key", m_key);
+        readValue<std::string>(*it, "subaccount", m_subAccount);
+        readValue<std::string>(*it, "sign", m_sign);
+        readValue<std::int64_t>(*it, "time", m_time);
+    }
 }
 
 nlohmann::json TickerData::toJson() const {
-    nlohmann::json json;
-    json["bid"] = m_bid;
-    json["ask"] = m_ask;
-    json["bidSize"] = m_bidSize;
-    json["askSize"] = m_askSize;
-    json["last"] = m_last;
-    json["time"] = m_time;
-    return json;
+    return toJsonFields(*this);
 }
 
 void TickerData::fromJson(const nlohmann::json &json) {
-    readValue<double>(json, "bid", m_bid);
-    readValue<double>(json, "ask", m_ask);
-    readValue<double>(json, "bidSize", m_bidSize);
-    readValue<double>(json, "askSize", m_askSize);
-    readValue<double>(json, "last", m_last);
-    readValue<std::int64_t>(json, "time", m_time);
+    fromJsonFields(json, *this);
+}
+
+nlohmann::json OrderBookData::toJson() const {
+    return toJsonFields(*this);
+}
+
+void OrderBookData::fromJson(const nlohmann::json &json) {
+    fromJsonFields(json, *this);
+}
+
+nlohmann::json MarketsData::toJson() const {
+    return toJsonFields(*this);
+}
+
+void MarketsData::fromJson(const nlohmann::json &json) {
+    fromJsonFields(json, *this);
+}
+
+nlohmann::json Trade::toJson() const {
+    return toJsonFields(*this);
+}
+
+void Trade::fromJson(const nlohmann::json &json) {
+    fromJsonFields(json, *this);
+}
+
+nlohmann::json TradesData::toJson() const {
+    return toJsonValue(m_trades);
+}
+
+void TradesData::fromJson(const nlohmann::json &json) {
+    fromJsonValue(json, m_trades);
 }
 
 nlohmann::json FillData::toJson() const {
-    nlohmann::json json;
-    json["fee"] = m_fee;
-    json["feeRate"] = m_feeRate;
-    json["future"] = m_future;
-    json["id"] = m_id;
-    json["liquidity"] = m_liquidity;
-    json["market"] = m_market;
-    json["orderId"] = m_orderId;
-    json["tradeId"] = m_tradeId;
-    json["price"] = m_price;
-    json["side"] = m_side._to_string();
-    json["size"] = m_size;
-    json["time"] = m_time;
-    json["type"] = m_type;
-    return json;
+    return toJsonFields(*this);
 }
 
 void FillData::fromJson(const nlohmann::json &json) {
-    readValue<double>(json, "fee", m_fee);
-    readValue<double>(json, "feeRate", m_feeRate);
-    readValue<std::string>(json, "future", m_future);
-    readValue<std::int64_t>(json, "id", m_id);
-    readValue<std::string>(json, "liquidity", m_liquidity);
-    readValue<std::string>(json, "market", m_market);
-    readValue<std::int64_t>(json, "orderId", m_orderId);
-    readValue<std::int64_t>(json, "tradeId", m_tradeId);
-    readValue<double>(json, "price", m_price);
-    readEnum<Side>(json, "side", m_side);
-    readValue<double>(json, "size", m_size);
-    readValue<std::string>(json, "time", m_time);
-    readValue<std::string>(json, "type", m_type);
+    fromJsonFields(json, *this);
 }
 
 nlohmann::json OrderData::toJson() const {
-    nlohmann::json json;
+    return toJsonFields(*this);
+}
 
-    json["id"] = m_id;
-    json["clientId"] = m_clientId;
-    json["market"] = m_market;
-    json["type"] = m_type._to_string();
-    json["side"] = m_side._to_string();
+void OrderData::fromJson(const nlohmann::json &json) {
+    fromJsonFields(json, *this);
+}
 
-    json["size"] = m_size;
-    json["price"] = m_price;
-    json["reduceOnly"] = m_reduceOnly;
-    json["ioc"] = m_ioc;
-    json["postOnly"] = m_postOnly;
+nlohmann::json Fills::toJson() const {
+    return toJsonValue(m_fills);
+}
 
-    std::string statusStr = m_status._to_string();;
-    std::transform(statusStr.begin(), statusStr.end(), statusStr.begin(),
-                   [](unsigned char c) { return std::tolower(c); });
+void Fills::fromJson(const nlohmann::json &json) {
+    fromJsonValue(json, m_fills);
+}
 
-    json["status"] = statusStr;
-    json["filledSize"] = m_filledSize;
-    json["remainingSize"] = m_remainingSize;
-    json["avgFillPrice"] = m_avgFillPrice;
-    return json;
+nlohmann::json Orders::toJson() const {
+    return toJsonValue(m_orders);
 }
 
-void OrderData::fromJson(const nlohmann::json &json) {
-    readValue<std::int64_t>(json, "id", m_id);
-    readValue<std::string>(json, "clientId", m_clientId);
-    readValue<std::string>(json, "market", m_market);
-    readEnum<OrderType>(json, "type", m_type);
-    readEnum<Side>(json, "side", m_side);
-    readValue<double>(json, "size", m_size);
-    readValue<double>(json, "price", m_price);
-    readValue<bool>(json, "reduceOnly", m_reduceOnly);
-    readValue<bool>(json, "ioc", m_ioc);
-    readValue<bool>(json, "postOnly", m_postOnly);
-    readEnum<OrderStatus>(json, "status", m_status);
-    readValue<double>(json, "filledSize", m_filledSize);
-    readValue<double>(json, "remainingSize", m_remainingSize);
-    readValue<double>(json, "avgFillPrice", m_avgFillPrice);
+void Orders::fromJson(const nlohmann::json &json) {
+    fromJsonValue(json, m_orders);
 }
 
 nlohmann::json FTXPayData::toJson() const {
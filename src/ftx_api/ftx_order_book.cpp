@@ -0,0 +1,96 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include <ftx_api/ftx_order_book.h>
+#include <boost/crc.hpp>
+#include <algorithm>
+
+namespace ftx {
+
+/// A level of size zero removes the price, otherwise the level is inserted or replaced
+template<typename Compare>
+static void applyLevels(std::vector<OrderBookLevel> &side, const std::vector<OrderBookLevel> &levels,
+                        Compare compare) {
+    for (const auto &level: levels) {
+        const auto it = std::lower_bound(side.begin(), side.end(), level.m_price,
+                                         [&](const OrderBookLevel &l, double price) {
+                                             return compare(l.m_price, price);
+                                         });
+        const bool found = it != side.end() && it->m_price == level.m_price;
+
+        if (level.m_size == 0.0) {
+            if (found) {
+                side.erase(it);
+            }
+        } else if (found) {
+            *it = level;
+        } else {
+            side.insert(it, level);
+        }
+    }
+}
+
+static void processLevel(boost::crc_32_type &crc, const OrderBookLevel &level, bool &first) {
+    if (!first) {
+        crc.process_byte(':');
+    }
+
+    first = false;
+    const auto price = level.m_priceText.view();
+    const auto size = level.m_sizeText.view();
+    crc.process_bytes(price.data(), price.size());
+    crc.process_byte(':');
+    crc.process_bytes(size.data(), size.size());
+}
+
+bool OrderBook::apply(const OrderBookData &data) {
+
+    if (data.m_action == +OperationResponse::partial) {
+        m_bids.clear();
+        m_asks.clear();
+        m_valid = true;
+    } else if (!m_valid) {
+        return true;
+    }
+
+    applyLevels(m_bids, data.m_bids, std::greater<>());
+    applyLevels(m_asks, data.m_asks, std::less<>());
+    m_time = data.m_time;
+
+    if (checksum() != data.m_checksum) {
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+void OrderBook::clear() {
+    m_bids.clear();
+    m_asks.clear();
+    m_valid = false;
+}
+
+std::uint32_t OrderBook::checksum() const {
+    boost::crc_32_type crc;
+    bool first = true;
+
+    for (std::size_t i = 0; i < CHECKSUM_DEPTH && (i < m_bids.size() || i < m_asks.size()); ++i) {
+        if (i < m_bids.size()) {
+            processLevel(crc, m_bids[i], first);
+        }
+
+        if (i < m_asks.size()) {
+            processLevel(crc, m_asks[i], first);
+        }
+    }
+
+    return crc.checksum();
+}
+}
@@ -0,0 +1,166 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include <ftx_api/ftx_order_store.h>
+#include <algorithm>
+
+namespace ftx {
+
+OrderStore::Entry *OrderStore::find(const Order &order) {
+    auto it = m_orders.find(order.m_id);
+
+    if (it == m_orders.end() && !order.m_clientId.empty()) {
+        const auto clientIt = m_clientIds.find(order.m_clientId);
+
+        if (clientIt != m_clientIds.end()) {
+            it = m_orders.find(clientIt->second);
+        }
+    }
+
+    return it == m_orders.end() ? nullptr : &it->second;
+}
+
+void OrderStore::forget(std::int64_t id) {
+    const auto it = m_orders.find(id);
+
+    if (it == m_orders.end()) {
+        return;
+    }
+
+    const auto clientIt = m_clientIds.find(it->second.m_data.m_clientId);
+
+    if (clientIt != m_clientIds.end() && clientIt->second == id) {
+        m_clientIds.erase(clientIt);
+    }
+
+    m_orders.erase(it);
+}
+
+void OrderStore::add(const OrderData &orderData) {
+    auto [it, inserted] = m_orders.try_emplace(orderData.m_id);
+    auto &entry = it->second;
+
+    /// REST reconciliation may deliver an older state after the final one
+    if (!inserted && entry.m_data.m_status == +OrderStatus::closed) {
+        return;
+    }
+
+    entry.m_data = orderData;
+    entry.m_unread = true;
+
+    if (!orderData.m_clientId.empty()) {
+        m_clientIds.insert_or_assign(orderData.m_clientId, orderData.m_id);
+    }
+
+    if (orderData.m_status == +OrderStatus::closed) {
+        m_closedOrders.push_back(orderData.m_id);
+
+        if (m_closedOrders.size() > MAX_CLOSED_ORDERS) {
+            forget(m_closedOrders.front());
+            m_closedOrders.pop_front();
+        }
+    }
+}
+
+std::optional<OrderData> OrderStore::take(const Order &order) {
+    auto *entry = find(order);
+
+    if (entry == nullptr || !entry->m_unread) {
+        return {};
+    }
+
+    entry->m_unread = false;
+    return entry->m_data;
+}
+
+std::optional<OrderData> OrderStore::takeClosed(const Order &order) {
+    auto *entry = find(order);
+
+    if (entry == nullptr || entry->m_data.m_status != +OrderStatus::closed) {
+        return {};
+    }
+
+    entry->m_unread = false;
+    return entry->m_data;
+}
+
+std::optional<OrderData> OrderStore::takeResting(const Order &order) {
+    auto *entry = find(order);
+
+    if (entry == nullptr || entry->m_data.m_status != +OrderStatus::open || entry->m_data.m_filledSize > 0.0) {
+        return {};
+    }
+
+    entry->m_unread = false;
+    return entry->m_data;
+}
+
+std::size_t OrderStore::size() const {
+    return m_orders.size();
+}
+
+void FillStore::forget(std::int64_t id) {
+    const auto it = m_fills.find(id);
+
+    if (it == m_fills.end()) {
+        return;
+    }
+
+    const auto orderIt = m_orderFills.find(it->second.m_data.m_orderId);
+
+    if (orderIt != m_orderFills.end()) {
+        std::erase(orderIt->second, id);
+
+        if (orderIt->second.empty()) {
+            m_orderFills.erase(orderIt);
+        }
+    }
+
+    m_fills.erase(it);
+}
+
+bool FillStore::add(const FillData &fillData) {
+    if (!m_fills.try_emplace(fillData.m_id, Entry{fillData}).second) {
+        return false;
+    }
+
+    m_orderFills[fillData.m_orderId].push_back(fillData.m_id);
+    m_fillIds.push_back(fillData.m_id);
+
+    if (m_fillIds.size() > MAX_FILLS) {
+        forget(m_fillIds.front());
+        m_fillIds.pop_front();
+    }
+
+    return true;
+}
+
+std::optional<FillData> FillStore::take(const Order &order) {
+    const auto orderIt = m_orderFills.find(order.m_id);
+
+    if (orderIt == m_orderFills.end()) {
+        return {};
+    }
+
+    for (const auto id: orderIt->second) {
+        auto &entry = m_fills.at(id);
+
+        if (entry.m_unread) {
+            entry.m_unread = false;
+            return entry.m_data;
+        }
+    }
+
+    return {};
+}
+
+std::size_t FillStore::size() const {
+    return m_fills.size();
+}
+}
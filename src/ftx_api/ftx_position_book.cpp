@@ -0,0 +1,97 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include <ftx_api/ftx_position_book.h>
+#include <cmath>
+#include <mutex>
+
+namespace ftx {
+
+bool PositionBook::load(const std::vector<Position> &positions, std::uint64_t sequence) {
+    std::unordered_map<std::string, Position> book;
+    book.reserve(positions.size());
+
+    for (const auto &position: positions) {
+        book.insert_or_assign(position.m_future, position);
+    }
+
+    std::unique_lock<std::shared_mutex> lk(m_locker);
+
+    if (m_suspended || sequence != m_sequence) {
+        return false;
+    }
+
+    m_positions = std::move(book);
+    m_loaded = true;
+    return true;
+}
+
+void PositionBook::apply(const FillData &fill) {
+    if (fill.m_future.empty()) {
+        return;
+    }
+
+    std::unique_lock<std::shared_mutex> lk(m_locker);
+    auto &position = m_positions[fill.m_future];
+
+    position.m_future = fill.m_future;
+    position.m_netSize += fill.m_side == +Side::buy ? fill.m_size : -fill.m_size;
+
+    if (fill.m_side == +Side::buy) {
+        position.m_cumulativeBuySize += fill.m_size;
+    } else {
+        position.m_cumulativeSellSize += fill.m_size;
+    }
+
+    position.m_size = std::abs(position.m_netSize);
+    position.m_side = position.m_netSize < 0.0 ? Side::sell : Side::buy;
+    ++m_sequence;
+}
+
+void PositionBook::clear() {
+    std::unique_lock<std::shared_mutex> lk(m_locker);
+    m_positions.clear();
+    m_loaded = false;
+    m_suspended = true;
+    ++m_sequence;
+}
+
+void PositionBook::resume() {
+    std::unique_lock<std::shared_mutex> lk(m_locker);
+    m_suspended = false;
+}
+
+std::uint64_t PositionBook::sequence() const {
+    std::shared_lock<std::shared_mutex> lk(m_locker);
+    return m_sequence;
+}
+
+bool PositionBook::isValid() const {
+    std::shared_lock<std::shared_mutex> lk(m_locker);
+    return m_loaded;
+}
+
+std::optional<Position> PositionBook::find(const std::string &future) const {
+    std::shared_lock<std::shared_mutex> lk(m_locker);
+
+    if (!m_loaded) {
+        return {};
+    }
+
+    const auto it = m_positions.find(future);
+
+    if (it == m_positions.end()) {
+        Position position;
+        position.m_future = future;
+        return position;
+    }
+
+    return it->second;
+}
+}
@@ -0,0 +1,140 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include <ftx_api/ftx_rate_limiter.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace ftx {
+
+static const double DEFAULT_REQUESTS_PER_SECOND = 30.0;
+static const double DEFAULT_BURST = 30.0;
+
+using SteadyClock = std::chrono::steady_clock;
+
+struct RateLimiter::P {
+    mutable std::mutex m_locker;
+    std::condition_variable m_condition;
+    double m_requestsPerSecond = DEFAULT_REQUESTS_PER_SECOND;
+    double m_burst = DEFAULT_BURST;
+    double m_tokens = DEFAULT_BURST;
+    SteadyClock::time_point m_lastRefill = SteadyClock::now();
+
+    /// Tickets of the waiting requests per priority
+    std::array<std::deque<std::uint64_t>, RequestPriority::_size()> m_queues;
+    std::uint64_t m_nextTicket = 0;
+    RateLimiterMetrics m_metrics;
+
+    void refill(SteadyClock::time_point now) {
+        const std::chrono::duration<double> elapsed = now - m_lastRefill;
+        m_tokens = std::min(m_burst, m_tokens + elapsed.count() * m_requestsPerSecond);
+        m_lastRefill = now;
+    }
+
+    /// @return True if no request of the same or higher priority is waiting ahead of the ticket
+    [[nodiscard]] bool isNext(std::size_t priority, std::uint64_t ticket) const {
+        for (std::size_t i = 0; i < priority; i++) {
+            if (!m_queues[i].empty()) {
+                return false;
+            }
+        }
+
+        return m_queues[priority].front() == ticket;
+    }
+};
+
+RateLimiter::RateLimiter() : m_p(spimpl::make_unique_impl<P>()) {
+}
+
+RateLimiter &RateLimiter::instance() {
+    static RateLimiter limiter;
+    return limiter;
+}
+
+void RateLimiter::setLimit(double requestsPerSecond, double burst) {
+    {
+        std::lock_guard<std::mutex> lk(m_p->m_locker);
+        m_p->refill(SteadyClock::now());
+        m_p->m_requestsPerSecond = std::max(requestsPerSecond, 0.1);
+        m_p->m_burst = std::max(burst, 1.0);
+        m_p->m_tokens = std::min(m_p->m_tokens, m_p->m_burst);
+    }
+
+    m_p->m_condition.notify_all();
+}
+
+double RateLimiter::requestsPerSecond() const {
+    std::lock_guard<std::mutex> lk(m_p->m_locker);
+    return m_p->m_requestsPerSecond;
+}
+
+void RateLimiter::acquire(double weight, RequestPriority priority) {
+    const auto start = SteadyClock::now();
+    const auto index = priority._to_index();
+    std::unique_lock<std::mutex> lk(m_p->m_locker);
+
+    weight = std::clamp(weight, 0.0, m_p->m_burst);
+
+    const auto ticket = m_p->m_nextTicket++;
+    m_p->m_queues[index].push_back(ticket);
+    m_p->m_metrics.m_queueDepth++;
+    bool delayed = false;
+
+    for (;;) {
+        const auto now = SteadyClock::now();
+        m_p->refill(now);
+
+        if (!m_p->isNext(index, ticket)) {
+            delayed = true;
+            m_p->m_condition.wait(lk);
+        } else if (m_p->m_tokens < weight) {
+            delayed = true;
+            const std::chrono::duration<double> missing((weight - m_p->m_tokens) / m_p->m_requestsPerSecond);
+            m_p->m_condition.wait_until(lk, now + std::chrono::duration_cast<SteadyClock::duration>(missing));
+        } else {
+            break;
+        }
+    }
+
+    m_p->m_tokens -= weight;
+    m_p->m_queues[index].pop_front();
+
+    const auto waitUs = std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - start).count();
+    auto &metrics = m_p->m_metrics;
+    metrics.m_queueDepth--;
+    metrics.m_numRequests++;
+    metrics.m_totalWaitUs += waitUs;
+    metrics.m_maxWaitUs = std::max(metrics.m_maxWaitUs, waitUs);
+
+    if (delayed) {
+        metrics.m_numDelayed++;
+    }
+
+    lk.unlock();
+
+    /// The next waiting request may be of any priority
+    m_p->m_condition.notify_all();
+}
+
+RateLimiterMetrics RateLimiter::metrics() const {
+    std::lock_guard<std::mutex> lk(m_p->m_locker);
+    return m_p->m_metrics;
+}
+
+void RateLimiter::resetMetrics() {
+    std::lock_guard<std::mutex> lk(m_p->m_locker);
+    const auto queueDepth = m_p->m_metrics.m_queueDepth;
+    m_p->m_metrics = {};
+    m_p->m_metrics.m_queueDepth = queueDepth;
+}
+}
@@ -10,26 +10,122 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 #include <ftx_api/utils.h>
 #include <ftx_api/ftx_models.h>
 #include <ftx_api/ftx_rest_client.h>
+#include <ftx_api/ftx_json_decoder.h>
 #include <ftx_api/ftx_http_session.h>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/post.hpp>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <algorithm>
+#include <unordered_map>
 
 namespace ftx {
 
 const char *API_URI = "ftx.com";
 
+/// Number of worker threads executing asynchronous requests, matches the HTTPSession connection pool size
+static const std::size_t ASYNC_WORKERS = 4;
+
+/// Maximum number of candles returned by the server for a single request
+static const std::int64_t MAX_CANDLES_PER_REQUEST = 1500;
+
 struct RESTClient::P {
+    mutable std::mutex m_sessionLocker;
     std::shared_ptr<HTTPSession> m_httpSession;
     std::string m_apiKey;
     std::string m_apiSecret;
     std::string m_subAccountName;
+    mutable boost::asio::thread_pool m_workers{ASYNC_WORKERS};
+    std::atomic<std::size_t> m_historyConcurrency = 1;
+
+    /// Decoded results shared by identical requests, the value type is given by the target
+    using SharedResult = std::shared_ptr<const void>;
+
+    struct CachedResult {
+        SharedResult m_value;
+        std::chrono::steady_clock::time_point m_time;
+    };
+
+    struct Flight {
+        std::shared_future<SharedResult> m_future;
+        std::uint64_t m_generation;
+    };
+
+    mutable std::mutex m_flightsLocker;
+    mutable std::unordered_map<std::string, Flight> m_flights;
+    mutable std::unordered_map<std::string, CachedResult> m_cache;
+    std::chrono::milliseconds m_maxAge{0};
+
+    /// Incremented by setCredentials, requests signed for a previous account are neither joined nor cached
+    std::uint64_t m_generation = 0;
+
+    [[nodiscard]] std::shared_ptr<HTTPSession> session() const {
+        std::lock_guard<std::mutex> lk(m_sessionLocker);
+        return m_httpSession;
+    }
 
+    template<typename F>
+    std::future<std::invoke_result_t<F>> post(F &&f) const {
+        using ResultType = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<F>(f));
+        auto future = task->get_future();
+        boost::asio::post(m_workers, [task] { (*task)(); });
+        return future;
+    }
+
+    /**
+     * GET and decode a target, concurrent calls for the same target share a single request and its result or
+     * exception. The result is reused for maxAge when enabled.
+     */
+    template<typename ValueType>
+    [[nodiscard]] ValueType getShared(const std::string &target) const;
+
+    /// Remove the flight of a target unless it was replaced by a flight of a newer generation, m_flightsLocker held
+    void eraseFlight(const std::string &target, std::uint64_t generation) const {
+        const auto it = m_flights.find(target);
+
+        if (it != m_flights.end() && it->second.m_generation == generation) {
+            m_flights.erase(it);
+        }
+    }
+
+    /// Download a single page of candles
     [[nodiscard]] std::vector<Candle>
     getHistoricalPrices(const std::string &marketName, std::int32_t resolutionInSecs, std::int64_t from,
                         std::int64_t to) const;
+
+    /// Download candles page by page backwards from "to"
+    [[nodiscard]] std::vector<Candle>
+    getHistoricalPricesSerial(const std::string &marketName, std::int32_t resolutionInSecs, std::int64_t from,
+                              std::int64_t to) const;
+
+    /// Split [from, to] into windows of MAX_CANDLES_PER_REQUEST candles and download them concurrently
+    [[nodiscard]] std::vector<Candle>
+    getHistoricalPricesParallel(const std::string &marketName, std::int32_t resolutionInSecs, std::int64_t from,
+                                std::int64_t to, std::size_t concurrency) const;
 };
 
 template<typename ValueType>
 ValueType handleFTXResponse(const http::response<http::string_body> &response) {
     ValueType retVal;
+
+    if constexpr (isStreamDecodable<ValueType>) {
+        bool success = false;
+        std::string error;
+
+        if (decodeResponse(response.body(), success, error, retVal)) {
+            if (success) {
+                return retVal;
+            }
+
+            throw std::runtime_error(std::format("FTX API error: {}", error).c_str());
+        }
+
+        /// Unexpected layout, decode through the DOM
+        retVal = ValueType{};
+    }
+
     Response ftxResponse;
     ftxResponse.fromJson(nlohmann::json::parse(response.body()));
 
@@ -38,25 +134,87 @@ ValueType handleFTXResponse(const http::response<http::string_body> &response) {
             retVal.fromJson(ftxResponse.m_result);
             return retVal;
         } else {
-            throw std::exception(std::format("FTX API error: {}", ftxResponse.m_error).c_str());
+            throw std::runtime_error(std::format("FTX API error: {}", ftxResponse.m_error).c_str());
         }
     } else {
         if (ftxResponse.m_success) {
             retVal.m_success = true;
             return retVal;
         } else {
-            throw std::exception(std::format("FTX API error: {}", ftxResponse.m_error).c_str());
+            throw std::runtime_error(std::format("FTX API error: {}", ftxResponse.m_error).c_str());
         }
     }
 }
 
 http::response<http::string_body> checkResponse(const http::response<http::string_body> &response) {
     if (response.result() != boost::beast::http::status::ok) {
-        throw std::exception(std::format("Bad response, code {}, msg: {}", response.result_int(), response.body()).c_str());
+        throw std::runtime_error(std::format("Bad response, code {}, msg: {}", response.result_int(), response.body()).c_str());
     }
     return response;
 }
 
+template<typename ValueType>
+ValueType RESTClient::P::getShared(const std::string &target) const {
+    std::promise<SharedResult> promise;
+    std::shared_future<SharedResult> future;
+    std::chrono::milliseconds maxAge;
+    std::uint64_t generation;
+
+    {
+        std::lock_guard<std::mutex> lk(m_flightsLocker);
+        maxAge = m_maxAge;
+        generation = m_generation;
+
+        if (maxAge.count() > 0) {
+            const auto it = m_cache.find(target);
+
+            if (it != m_cache.end() && std::chrono::steady_clock::now() - it->second.m_time < maxAge) {
+                return *std::static_pointer_cast<const ValueType>(it->second.m_value);
+            }
+        }
+
+        const auto it = m_flights.find(target);
+
+        if (it != m_flights.end()) {
+            future = it->second.m_future;
+        } else {
+            m_flights.emplace(target, Flight{promise.get_future().share(), generation});
+        }
+    }
+
+    if (future.valid()) {
+        return *std::static_pointer_cast<const ValueType>(future.get());
+    }
+
+    try {
+        auto value = std::make_shared<const ValueType>(
+                handleFTXResponse<ValueType>(checkResponse(session()->methodGet(target))));
+
+        {
+            std::lock_guard<std::mutex> lk(m_flightsLocker);
+            eraseFlight(target, generation);
+
+            if (maxAge.count() > 0 && generation == m_generation) {
+                const auto now = std::chrono::steady_clock::now();
+                std::erase_if(m_cache, [&](const auto &item) { return now - item.second.m_time >= maxAge; });
+                m_cache.insert_or_assign(target, CachedResult{value, now});
+            }
+        }
+
+        promise.set_value(value);
+        return *value;
+    }
+    catch (...) {
+        {
+            std::lock_guard<std::mutex> lk(m_flightsLocker);
+            eraseFlight(target, generation);
+        }
+
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
 RESTClient::RESTClient(const std::string &apiKey, const std::string &apiSecret, const std::string &subAccountName)
         : m_p(spimpl::make_unique_impl<P>()) {
     m_p->m_apiKey = apiKey;
@@ -64,6 +222,12 @@ RESTClient::RESTClient(const std::string &apiKey, const std::string &apiSecret,
     m_p->m_subAccountName = subAccountName;
 
     m_p->m_httpSession = std::make_shared<HTTPSession>(API_URI, m_p->m_apiKey, m_p->m_apiSecret, m_p->m_subAccountName);
+    m_p->m_httpSession->setMaxConnections(ASYNC_WORKERS);
+}
+
+RESTClient::~RESTClient() {
+    /// Let already queued requests finish so no future is left with a broken promise
+    m_p->m_workers.join();
 }
 
 bool RESTClient::isValidCandleResolution(std::int32_t resolution) {
@@ -92,20 +256,48 @@ RESTClient::setCredentials(const std::string &apiKey, const std::string &apiSecr
     m_p->m_apiSecret = apiSecret;
     m_p->m_subAccountName = subAccountName;
 
-    m_p->m_httpSession.reset();
-    m_p->m_httpSession = std::make_shared<HTTPSession>(API_URI, m_p->m_apiKey, m_p->m_apiSecret, m_p->m_subAccountName);
+    auto httpSession = std::make_shared<HTTPSession>(API_URI, m_p->m_apiKey, m_p->m_apiSecret, m_p->m_subAccountName);
+    httpSession->setMaxConnections(std::max<std::size_t>(ASYNC_WORKERS, m_p->m_historyConcurrency));
+
+    {
+        std::lock_guard<std::mutex> lk(m_p->m_sessionLocker);
+        m_p->m_httpSession = std::move(httpSession);
+    }
+
+    /// Results of the previous account must not be served, neither finished nor running ones
+    std::lock_guard<std::mutex> lk(m_p->m_flightsLocker);
+    m_p->m_generation++;
+    m_p->m_flights.clear();
+    m_p->m_cache.clear();
+}
+
+void RESTClient::setMaxAge(std::chrono::milliseconds maxAge) {
+    std::lock_guard<std::mutex> lk(m_p->m_flightsLocker);
+    m_p->m_maxAge = std::max(maxAge, std::chrono::milliseconds(0));
+
+    if (m_p->m_maxAge.count() == 0) {
+        m_p->m_cache.clear();
+    }
+}
+
+std::chrono::milliseconds RESTClient::maxAge() const {
+    std::lock_guard<std::mutex> lk(m_p->m_flightsLocker);
+    return m_p->m_maxAge;
 }
 
 Account RESTClient::getAccountInfo() const {
 
-    const auto response = checkResponse(m_p->m_httpSession->methodGet("account"));
-    return handleFTXResponse<Account>(response);
+    return m_p->getShared<Account>("account");
 }
 
 Market RESTClient::getMarket(const std::string &name) const {
 
-    const auto response = checkResponse(m_p->m_httpSession->methodGet("markets/" + name));
-    return handleFTXResponse<Market>(response);
+    return m_p->getShared<Market>("markets/" + name);
+}
+
+std::vector<Market> RESTClient::getMarkets() const {
+
+    return m_p->getShared<Markets>("markets").m_markets;
 }
 
 Position RESTClient::getPosition(const std::string &name) const {
@@ -122,16 +314,49 @@ Position RESTClient::getPosition(const std::string &name) const {
     return {};
 }
 
-std::vector<Position> RESTClient::getPositions() const {
+std::vector<Position> RESTClient::getPositions(bool fresh) const {
+
+    if (fresh) {
+        const auto response = checkResponse(m_p->session()->methodGet("positions"));
+        return handleFTXResponse<Positions>(response).m_positions;
+    }
+
+    return m_p->getShared<Positions>("positions").m_positions;
+}
+
+/// Compose start_time/end_time query of the list endpoints
+static std::string composeTimeRangeQuery(std::int64_t from, std::int64_t to) {
+    std::string query;
+
+    if (from > 0) {
+        query += "start_time=" + std::to_string(from);
+    }
+
+    if (to > 0) {
+        query += (query.empty() ? "" : "&") + std::string("end_time=") + std::to_string(to);
+    }
 
-    const auto response = checkResponse(m_p->m_httpSession->methodGet("positions"));
-    const auto responseData = handleFTXResponse<Positions>(response);
-    return responseData.m_positions;
+    return query.empty() ? query : "?" + query;
+}
+
+std::vector<FillData> RESTClient::getFills(std::int64_t from, std::int64_t to) const {
+
+    const auto response = checkResponse(m_p->session()->methodGet("fills" + composeTimeRangeQuery(from, to)));
+    const auto responseData = handleFTXResponse<Fills>(response);
+    return responseData.m_fills;
+}
+
+std::vector<OrderData> RESTClient::getOrderHistory(std::int64_t from, std::int64_t to) const {
+
+    const auto response = checkResponse(
+            m_p->session()->methodGet("orders/history" + composeTimeRangeQuery(from, to)));
+    const auto responseData = handleFTXResponse<Orders>(response);
+    return responseData.m_orders;
 }
 
 Order RESTClient::placeOrder(const Order &order) const {
 
-    const auto response = checkResponse(m_p->m_httpSession->methodPost("orders", order.toJson().dump()));
+    const auto response = checkResponse(m_p->session()->methodPost("orders", order.toJson().dump()));
     return handleFTXResponse<Order>(response);
 }
 
@@ -145,7 +370,7 @@ bool RESTClient::cancelOrder(std::int32_t id, bool isClientId) const {
         path = "orders/by_client_id/" + std::to_string(id);
     }
 
-    const auto response = checkResponse(m_p->m_httpSession->methodDelete(path));
+    const auto response = checkResponse(m_p->session()->methodDelete(path));
     return handleFTXResponse<Response>(response).m_success;
 }
 
@@ -159,13 +384,13 @@ Order RESTClient::getOrderStatus(std::int32_t id, bool isClientId) const {
         path = "orders/by_client_id/" + std::to_string(id);
     }
 
-    const auto response = checkResponse(m_p->m_httpSession->methodGet(path));
+    const auto response = checkResponse(m_p->session()->methodGet(path));
     return handleFTXResponse<Order>(response);
 }
 
 bool RESTClient::cancelAllOrders(const std::string &market) const {
 
-    const auto response = checkResponse(m_p->m_httpSession->methodDelete("orders"));
+    const auto response = checkResponse(m_p->session()->methodDelete("orders"));
     return handleFTXResponse<Response>(response).m_success;
 }
 
@@ -177,37 +402,195 @@ RESTClient::P::getHistoricalPrices(const std::string &marketName, std::int32_t r
     pathStream << "markets/" << marketName << "/candles" << "?resolution=" << resolutionInSecs << "&start_time="
                << from << "&end_time=" << to;
 
-    const auto response = checkResponse(m_httpSession->methodGet(pathStream.str()));
+    const auto response = checkResponse(session()->methodGet(pathStream.str()));
     const auto responseData = handleFTXResponse<Candles>(response);
 
     return responseData.m_candles;
 }
 
 std::vector<Candle>
-RESTClient::getHistoricalPrices(const std::string &marketName, std::int32_t resolutionInSecs, std::int64_t from,
-                                std::int64_t to) const {
+RESTClient::P::getHistoricalPricesSerial(const std::string &marketName, std::int32_t resolutionInSecs,
+                                         std::int64_t from, std::int64_t to) const {
 
-    std::vector<Candle> retVal;
+    /// Pages are downloaded from the most recent one, they are joined in the final order once all are known
+    std::vector<std::vector<Candle>> pages;
+    std::size_t numCandles = 0;
     std::int64_t lastTo = to;
-    std::vector<Candle> candles;
 
-    if (from < lastTo) {
-        candles = m_p->getHistoricalPrices(marketName, resolutionInSecs, from, lastTo);
+    while (from < lastTo) {
+        auto candles = getHistoricalPrices(marketName, resolutionInSecs, from, lastTo);
+
+        if (candles.empty()) {
+            break;
+        }
+
+        lastTo = candles.front().m_startTime / MICROSECONDS_PER_SECOND - resolutionInSecs;
+        numCandles += candles.size();
+        pages.push_back(std::move(candles));
+    }
+
+    std::vector<Candle> retVal;
+    retVal.reserve(numCandles);
+
+    for (auto it = pages.rbegin(); it != pages.rend(); ++it) {
+        std::move(it->begin(), it->end(), std::back_inserter(retVal));
+    }
+
+    return retVal;
+}
+
+std::vector<Candle>
+RESTClient::P::getHistoricalPricesParallel(const std::string &marketName, std::int32_t resolutionInSecs,
+                                           std::int64_t from, std::int64_t to, std::size_t concurrency) const {
+
+    const std::int64_t windowSize = MAX_CANDLES_PER_REQUEST * resolutionInSecs;
+    std::vector<std::pair<std::int64_t, std::int64_t>> windows;
+
+    for (std::int64_t windowStart = from; windowStart <= to; windowStart += windowSize) {
+        windows.emplace_back(windowStart, std::min(windowStart + windowSize - resolutionInSecs, to));
+    }
+
+    /// Windows are claimed one by one by the caller and by helpers posted to m_workers. The caller takes part, so
+    /// the download completes even when all workers are busy (e.g. when called by getHistoricalPricesAsync).
+    struct Download {
+        std::string m_marketName;
+        std::vector<std::pair<std::int64_t, std::int64_t>> m_windows;
+        std::vector<std::vector<Candle>> m_pages;
+        std::vector<std::exception_ptr> m_errors;
+        std::atomic<std::size_t> m_nextWindow = 0;
+        std::size_t m_numDone = 0;
+        std::mutex m_locker;
+        std::condition_variable m_condition;
+    };
+
+    auto download = std::make_shared<Download>();
+    download->m_marketName = marketName;
+    download->m_windows = std::move(windows);
+    download->m_pages.resize(download->m_windows.size());
+    download->m_errors.resize(download->m_windows.size());
+
+    const auto run = [this, resolutionInSecs](Download &state) {
+        for (auto index = state.m_nextWindow++; index < state.m_windows.size(); index = state.m_nextWindow++) {
+            const auto [windowFrom, windowTo] = state.m_windows[index];
+
+            try {
+                /// Serial paging inside a window covers servers returning less than a full page
+                state.m_pages[index] = getHistoricalPricesSerial(state.m_marketName, resolutionInSecs, windowFrom,
+                                                                 windowTo);
+            }
+            catch (...) {
+                state.m_errors[index] = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lk(state.m_locker);
+
+            if (++state.m_numDone == state.m_windows.size()) {
+                state.m_condition.notify_all();
+            }
+        }
+    };
+
+    const auto numHelpers = std::min({concurrency, download->m_windows.size(), ASYNC_WORKERS + 1}) - 1;
+
+    for (std::size_t i = 0; i < numHelpers; i++) {
+        boost::asio::post(m_workers, [run, download] { run(*download); });
+    }
+
+    run(*download);
+
+    {
+        std::unique_lock<std::mutex> lk(download->m_locker);
+        download->m_condition.wait(lk, [&] { return download->m_numDone == download->m_windows.size(); });
+    }
+
+    std::vector<std::vector<Candle>> windowCandles;
+    std::size_t numCandles = 0;
+
+    for (std::size_t i = 0; i < download->m_pages.size(); i++) {
+        if (download->m_errors[i]) {
+            std::rethrow_exception(download->m_errors[i]);
+        }
+
+        numCandles += windowCandles.emplace_back(std::move(download->m_pages[i])).size();
     }
-    while (!candles.empty()) {
 
-        const auto first = candles.front();
-        const auto last = candles.back();
+    std::vector<Candle> retVal;
+    retVal.reserve(numCandles);
 
-        retVal.insert(retVal.begin(), candles.begin(), candles.end());
-        lastTo = getTimeStampFromString(candles.front().m_startTime, "%Y-%m-%dT%H:%M:%S:%z") - resolutionInSecs;
-        candles.clear();
+    for (auto &candles: windowCandles) {
+        for (auto &candle: candles) {
+            /// Windows may overlap by a candle at their boundaries
+            if (!retVal.empty() && candle.m_startTime <= retVal.back().m_startTime) {
+                continue;
+            }
 
-        if (from < lastTo) {
-            candles = m_p->getHistoricalPrices(marketName, resolutionInSecs, from, lastTo);
+            retVal.push_back(std::move(candle));
         }
     }
 
     return retVal;
 }
+
+void RESTClient::setHistoryConcurrency(std::size_t concurrency) {
+    m_p->m_historyConcurrency = std::max<std::size_t>(concurrency, 1);
+
+    const auto httpSession = m_p->session();
+
+    if (httpSession->maxConnections() < concurrency) {
+        httpSession->setMaxConnections(concurrency);
+    }
+}
+
+std::vector<Candle>
+RESTClient::getHistoricalPrices(const std::string &marketName, std::int32_t resolutionInSecs, std::int64_t from,
+                                std::int64_t to) const {
+
+    const std::size_t concurrency = m_p->m_historyConcurrency;
+
+    if (concurrency > 1 && to - from > MAX_CANDLES_PER_REQUEST * resolutionInSecs) {
+        return m_p->getHistoricalPricesParallel(marketName, resolutionInSecs, from, to, concurrency);
+    }
+
+    return m_p->getHistoricalPricesSerial(marketName, resolutionInSecs, from, to);
+}
+
+std::future<Account> RESTClient::getAccountInfoAsync() const {
+    return m_p->post([this] { return getAccountInfo(); });
+}
+
+std::future<Market> RESTClient::getMarketAsync(const std::string &name) const {
+    return m_p->post([this, name] { return getMarket(name); });
+}
+
+std::future<Position> RESTClient::getPositionAsync(const std::string &name) const {
+    return m_p->post([this, name] { return getPosition(name); });
+}
+
+std::future<std::vector<Position>> RESTClient::getPositionsAsync() const {
+    return m_p->post([this] { return getPositions(); });
+}
+
+std::future<Order> RESTClient::placeOrderAsync(const Order &order) const {
+    return m_p->post([this, order] { return placeOrder(order); });
+}
+
+std::future<bool> RESTClient::cancelOrderAsync(std::int32_t id, bool isClientId) const {
+    return m_p->post([this, id, isClientId] { return cancelOrder(id, isClientId); });
+}
+
+std::future<Order> RESTClient::getOrderStatusAsync(std::int32_t id, bool isClientId) const {
+    return m_p->post([this, id, isClientId] { return getOrderStatus(id, isClientId); });
+}
+
+std::future<bool> RESTClient::cancelAllOrdersAsync(const std::string &market) const {
+    return m_p->post([this, market] { return cancelAllOrders(market); });
+}
+
+std::future<std::vector<Candle>>
+RESTClient::getHistoricalPricesAsync(const std::string &marketName, std::int32_t resolutionInSecs, std::int64_t from,
+                                     std::int64_t to) const {
+    return m_p->post([this, marketName, resolutionInSecs, from, to] {
+        return getHistoricalPrices(marketName, resolutionInSecs, from, to);
+    });
+}
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include <ftx_api/ftx_ssl_context.h>
+#include <mutex>
+#include <map>
+
+namespace ftx {
+
+struct SSLContextFactory::P {
+    boost::asio::ssl::context m_ctx{boost::asio::ssl::context::sslv23_client};
+    std::mutex m_sessionsLocker;
+    std::map<std::string, SSL_SESSION *> m_sessions;
+
+    P() {
+        m_ctx.set_default_verify_paths();
+
+        /// Sessions are kept in m_sessions keyed by host, OpenSSL internal store is useless for clients
+        SSL_CTX_set_session_cache_mode(m_ctx.native_handle(),
+                                       SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(m_ctx.native_handle(), &P::onNewSession);
+    }
+
+    ~P() {
+        clearSessions();
+    }
+
+    void clearSessions() {
+        std::lock_guard<std::mutex> lk(m_sessionsLocker);
+
+        for (const auto &[host, session]: m_sessions) {
+            SSL_SESSION_free(session);
+        }
+
+        m_sessions.clear();
+    }
+
+    /// Called by OpenSSL after a full handshake (TLS 1.2) or when a session ticket arrives (TLS 1.3)
+    static int onNewSession(SSL *ssl, SSL_SESSION *session) {
+        const char *host = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+
+        if (!host) {
+            return 0;
+        }
+
+        auto &self = *SSLContextFactory::instance().m_p;
+        std::lock_guard<std::mutex> lk(self.m_sessionsLocker);
+        auto it = self.m_sessions.find(host);
+
+        if (it != self.m_sessions.end()) {
+            SSL_SESSION_free(it->second);
+            it->second = session;
+        } else {
+            self.m_sessions.emplace(host, session);
+        }
+
+        /// Returning 1 takes over the session reference
+        return 1;
+    }
+};
+
+SSLContextFactory::SSLContextFactory() : m_p(spimpl::make_unique_impl<P>()) {
+}
+
+SSLContextFactory &SSLContextFactory::instance() {
+    static SSLContextFactory factory;
+    return factory;
+}
+
+boost::asio::ssl::context &SSLContextFactory::context() {
+    return m_p->m_ctx;
+}
+
+bool SSLContextFactory::prepareSession(SSL *ssl, const std::string &host) {
+
+    /// Set SNI Hostname (many hosts need this to handshake successfully), it is also the session cache key
+    if (!SSL_set_tlsext_host_name(ssl, host.c_str())) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lk(m_p->m_sessionsLocker);
+    const auto it = m_p->m_sessions.find(host);
+
+    if (it != m_p->m_sessions.end() && SSL_SESSION_is_resumable(it->second)) {
+        SSL_set_session(ssl, it->second);
+    }
+
+    return true;
+}
+
+void SSLContextFactory::clearSessions() {
+    m_p->clearSessions();
+}
+}
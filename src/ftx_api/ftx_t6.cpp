@@ -0,0 +1,79 @@
+/*
+FTX Zorro Plugin
+https://github.com/vitakot/ftx_zorro_plugin
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include <ftx_api/ftx_t6.h>
+#include <ftx_api/utils.h>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FTX_T6_SSE2
+#endif
+
+namespace ftx {
+
+/// Same constants as microsecondsToVariantTime so both paths produce identical values
+static const double VARIANT_TIME_EPOCH = 25569.;
+static const double MICROSECONDS_PER_DAY = 86400. * MICROSECONDS_PER_SECOND;
+
+static void convertPrices(const Candle &candle, T6Record &record) {
+#ifdef FTX_T6_SSE2
+    /// {open, high} and {low, close} narrowed at once, then shuffled into {high, low, open, close}
+    const __m128 openHigh = _mm_cvtpd_ps(_mm_set_pd(candle.m_high, candle.m_open));
+    const __m128 lowClose = _mm_cvtpd_ps(_mm_set_pd(candle.m_close, candle.m_low));
+    const __m128 prices = _mm_movelh_ps(openHigh, lowClose);
+    _mm_storeu_ps(&record.m_high, _mm_shuffle_ps(prices, prices, _MM_SHUFFLE(3, 0, 2, 1)));
+#else
+    record.m_high = static_cast<float>(candle.m_high);
+    record.m_low = static_cast<float>(candle.m_low);
+    record.m_open = static_cast<float>(candle.m_open);
+    record.m_close = static_cast<float>(candle.m_close);
+#endif
+    record.m_val = 0.f;
+    record.m_vol = static_cast<float>(candle.m_volume);
+}
+
+std::size_t convertCandlesToT6(const std::vector<Candle> &candles, std::size_t maxCount, T6Record *records) {
+    const auto count = std::min(maxCount, candles.size());
+
+    if (count == 0) {
+        return 0;
+    }
+
+    const auto newest = candles.data() + candles.size() - 1;
+    std::size_t i = 0;
+
+#ifdef FTX_T6_SSE2
+    const __m128d scale = _mm_set1_pd(MICROSECONDS_PER_DAY);
+    const __m128d epoch = _mm_set1_pd(VARIANT_TIME_EPOCH);
+
+    for (; i + 1 < count; i += 2) {
+        const Candle &first = *(newest - i);
+        const Candle &second = *(newest - i - 1);
+
+        const __m128d times = _mm_add_pd(_mm_div_pd(_mm_set_pd(static_cast<double>(second.m_startTime),
+                                                               static_cast<double>(first.m_startTime)), scale),
+                                         epoch);
+        _mm_storel_pd(&records[i].m_time, times);
+        _mm_storeh_pd(&records[i + 1].m_time, times);
+
+        convertPrices(first, records[i]);
+        convertPrices(second, records[i + 1]);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        const Candle &candle = *(newest - i);
+        records[i].m_time = microsecondsToVariantTime(candle.m_startTime);
+        convertPrices(candle, records[i]);
+    }
+
+    return count;
+}
+}
@@ -8,10 +8,13 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 */
 
 #include <ftx_api/ftx_websocket.h>
+#include <ftx_api/ftx_ssl_context.h>
 #include <boost/beast/core.hpp>
 #include <boost/beast/ssl.hpp>
 #include <boost/beast/websocket.hpp>
 #include <iostream>
+#include <deque>
+#include <string_view>
 
 using namespace std::chrono_literals;
 
@@ -19,46 +22,59 @@ namespace ftx {
 
 static const int PING_INTERVAL_IN_S = 10;
 
+/// Initial capacity of the receive buffer, it grows to the largest frame seen and is reused afterwards
+static const std::size_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+
 #define FTX_CB_ON_ERROR(cb, ec) \
-    cb(__FILE__ "(" BOOST_PP_STRINGIZE(__LINE__) ")", (ec).value(), (ec).message(), nullptr, 0);
+    cb(__FILE__ "(" BOOST_PP_STRINGIZE(__LINE__) ")", (ec).value(), (ec).message(), std::string_view{});
 
 struct WebSocket::P {
 
-    boost::asio::ssl::context m_ssl;
     boost::asio::ip::tcp::resolver m_resolver;
     boost::beast::websocket::stream<boost::asio::ssl::stream<boost::asio::ip::tcp::socket>> m_ws;
-    boost::beast::multi_buffer m_buf;
+    boost::beast::flat_buffer m_buf;
+    onMessageReceivedCB m_messageCB;
     std::string m_host;
     bool m_stopRequested;
     std::string m_streamName;
-    boost::beast::multi_buffer m_wBuffer;
-    std::vector<nlohmann::json> m_requests;
+    std::deque<std::string> m_writeQueue;
+    bool m_connected = false;
+    bool m_writeInProgress = false;
+    std::weak_ptr<void> m_holder;
     boost::asio::steady_timer m_pingTimer;
     std::chrono::time_point<std::chrono::system_clock> m_lastPingTime{};
     std::chrono::time_point<std::chrono::system_clock> m_lastPongTime{};
     onLogMessage m_logMessageCB;
 
-    std::function<void(const boost::system::error_code &ec)> m_timerHandler;
-
-    explicit P(boost::asio::io_context &ioContext, onLogMessage onLogMessageCB) : m_ssl{
-            boost::asio::ssl::context::sslv23_client},
-                                                                                  m_resolver{ioContext},
-                                                                                  m_ws{ioContext, m_ssl}, m_buf{},
+    explicit P(boost::asio::io_context &ioContext, onLogMessage onLogMessageCB) : m_resolver{ioContext},
+                                                                                  m_ws{ioContext,
+                                                                                       SSLContextFactory::instance().context()},
+                                                                                  m_buf{},
                                                                                   m_stopRequested{},
                                                                                   m_pingTimer(ioContext,
                                                                                               boost::asio::chrono::seconds(
                                                                                                       PING_INTERVAL_IN_S)),
                                                                                   m_logMessageCB(std::move(
                                                                                           onLogMessageCB)) {
+    }
 
-        m_timerHandler = [this](const boost::system::error_code &ec) {
+    /// The handler holds the holder like the read and write handlers, a cancelled wait must not touch anything
+    void startPingTimer() {
+        auto holder = m_holder.lock();
 
-            if (!m_stopRequested) {
-                ping();
-                m_pingTimer.expires_from_now(boost::asio::chrono::seconds(PING_INTERVAL_IN_S));
-                m_pingTimer.async_wait(m_timerHandler);
+        if (!holder) {
+            return;
+        }
+
+        m_pingTimer.async_wait([this, holder = std::move(holder)](const boost::system::error_code &ec) {
+            if (ec == boost::asio::error::operation_aborted || m_stopRequested) {
+                return;
             }
-        };
+
+            ping();
+            m_pingTimer.expires_from_now(boost::asio::chrono::seconds(PING_INTERVAL_IN_S));
+            startPingTimer();
+        });
     }
 
     void
@@ -66,13 +82,11 @@ struct WebSocket::P {
                onMessageReceivedCB cb,
                holderType holder) {
         m_host = host;
-        m_requests = requests;
+        m_holder = holder;
+        m_buf.reserve(RECEIVE_BUFFER_SIZE);
 
-        if (!m_requests.empty()) {
-            auto msg = m_requests.back().dump();
-            m_requests.pop_back();
-            size_t n = buffer_copy(m_wBuffer.prepare(msg.size()), boost::asio::buffer(msg));
-            m_wBuffer.commit(n);
+        for (const auto &request: requests) {
+            m_writeQueue.push_back(request.dump());
         }
 
         m_resolver.async_resolve(
@@ -92,7 +106,7 @@ struct WebSocket::P {
 
     void
     asyncConnect(const boost::asio::ip::tcp::resolver::results_type &res, onMessageReceivedCB cb, holderType holder) {
-        if (!SSL_set_tlsext_host_name(m_ws.next_layer().native_handle(), m_host.c_str())) {
+        if (!SSLContextFactory::instance().prepareSession(m_ws.next_layer().native_handle(), m_host)) {
             auto errorCode = boost::beast::error_code(
                     static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category()
             );
@@ -147,7 +161,7 @@ struct WebSocket::P {
                 }
         );
 
-        m_pingTimer.async_wait(m_timerHandler);
+        startPingTimer();
     }
 
     void onAsyncSSLHandshake(onMessageReceivedCB cb, holderType holder) {
@@ -159,6 +173,7 @@ struct WebSocket::P {
 
     void stop() {
         m_stopRequested = true;
+        m_pingTimer.cancel();
 
         if (m_ws.next_layer().next_layer().is_open()) {
             boost::system::error_code ec;
@@ -166,12 +181,7 @@ struct WebSocket::P {
         }
     }
 
-    void startReadWrite(boost::system::error_code ec, const onMessageReceivedCB &cb, const holderType &holder) {
-        startRead(ec, cb, holder);
-        startWrite(ec, cb, holder);
-    }
-
-    void startRead(boost::system::error_code ec, onMessageReceivedCB cb, holderType holder) {
+    void startReadWrite(boost::system::error_code ec, onMessageReceivedCB cb, holderType holder) {
         if (ec) {
             if (!m_stopRequested) {
                 FTX_CB_ON_ERROR(cb, ec);
@@ -182,39 +192,62 @@ struct WebSocket::P {
             return;
         }
 
+        m_connected = true;
+        m_messageCB = std::move(cb);
+
+        startRead(std::move(holder));
+        startWrite();
+    }
+
+    /// The callback is kept in m_messageCB, the read handler captures only the holder to stay small
+    void startRead(holderType holder) {
         m_ws.async_read(
-                m_buf, [this, cb = std::move(cb), holder = std::move(holder)]
-                        (boost::system::error_code ec, std::size_t rd) mutable {
-                    onRead(ec, rd, std::move(cb), std::move(holder));
+                m_buf, [this, holder = std::move(holder)](boost::system::error_code ec, std::size_t rd) mutable {
+                    onRead(ec, rd, std::move(holder));
                 }
         );
     }
 
-    void startWrite(boost::system::error_code ec, onMessageReceivedCB cb, holderType holder) {
-
-        if (ec) {
-            if (!m_stopRequested) {
-                FTX_CB_ON_ERROR(cb, ec);
-            }
+    /// Write queued requests one by one, must be called from the IO context thread
+    void startWrite() {
+        if (!m_connected || m_writeInProgress || m_writeQueue.empty() || m_stopRequested) {
+            return;
+        }
 
-            stop();
+        auto holder = m_holder.lock();
 
+        if (!holder) {
             return;
         }
 
+        m_writeInProgress = true;
+
         m_ws.async_write(
-                m_wBuffer.data(),
-                [this, cb = std::move(cb), holder = std::move(holder)]
-                        (boost::system::error_code ec, std::size_t rd) mutable {
-                    onWrite(ec, rd, std::move(cb), std::move(holder));
+                boost::asio::buffer(m_writeQueue.front()),
+                [this, holder = std::move(holder)](boost::system::error_code ec, std::size_t wr) {
+                    onWrite(ec, wr);
                 }
         );
     }
 
-    void onRead(boost::system::error_code ec, std::size_t rd, onMessageReceivedCB cb, holderType holder) {
+    void send(std::string request) {
+        auto holder = m_holder.lock();
+
+        if (!holder) {
+            return;
+        }
+
+        boost::asio::post(m_ws.get_executor(),
+                          [this, holder = std::move(holder), request = std::move(request)]() mutable {
+                              m_writeQueue.push_back(std::move(request));
+                              startWrite();
+                          });
+    }
+
+    void onRead(boost::system::error_code ec, std::size_t rd, holderType holder) {
         if (ec) {
             if (!m_stopRequested) {
-                FTX_CB_ON_ERROR(cb, ec);
+                FTX_CB_ON_ERROR(m_messageCB, ec);
             }
 
             stop();
@@ -222,43 +255,35 @@ struct WebSocket::P {
             return;
         }
 
-        auto size = m_buf.size();
-        assert(size == rd);
+        assert(m_buf.size() == rd);
 
-        std::string strBuffer;
-        strBuffer.reserve(size);
-
-        for (const auto &it: m_buf.data()) {
-            strBuffer.append(static_cast<const char *>(it.data()), it.size());
-        }
+        /// The frame is contiguous in the flat buffer, it is valid only during the callback
+        const auto data = m_buf.cdata();
+        const std::string_view frame(static_cast<const char *>(data.data()), data.size());
 
+        bool ok = m_messageCB(nullptr, 0, std::string{}, frame);
         m_buf.consume(m_buf.size());
 
-        bool ok = cb(nullptr, 0, std::string{}, strBuffer.data(), strBuffer.size());
         if (!ok) {
             stop();
         } else {
-            startRead(boost::system::error_code{}, std::move(cb), std::move(holder));
+            startRead(std::move(holder));
         }
     }
 
-    void onWrite(boost::system::error_code ec, std::size_t rd, onMessageReceivedCB cb, holderType holder) {
-        boost::ignore_unused(rd);
+    void onWrite(boost::system::error_code ec, std::size_t wr) {
+        boost::ignore_unused(wr);
+        m_writeInProgress = false;
 
         if (ec) {
+            if (m_logMessageCB && !m_stopRequested) {
+                m_logMessageCB(LogSeverity::Error, std::format("{}: {}\n", MAKE_FILELINE, ec.message()));
+            }
             return;
         }
 
-        // Clear the buffer
-        m_wBuffer.consume(m_wBuffer.size());
-
-        if (!m_requests.empty()) {
-            auto msg = m_requests.back().dump();
-            m_requests.pop_back();
-            size_t n = buffer_copy(m_wBuffer.prepare(msg.size()), boost::asio::buffer(msg));
-            m_wBuffer.commit(n);
-            startWrite(boost::system::error_code{}, std::move(cb), std::move(holder));
-        }
+        m_writeQueue.pop_front();
+        startWrite();
     }
 
     void ping() {
@@ -275,7 +300,11 @@ struct WebSocket::P {
                 m_logMessageCB(LogSeverity::Error,
                                std::format("{}: {}\n", MAKE_FILELINE, "ping expired, closing socket..."));
             }
-            stop();
+
+            /// Close the transport only, the pending read fails and reports the error so the connection can be
+            /// re-established by the owner
+            boost::system::error_code ec;
+            boost::beast::get_lowest_layer(m_ws).close(ec);
             return;
         }
 
@@ -306,6 +335,10 @@ void WebSocket::start(const std::string &host, const std::string &port, const st
     return m_p->asyncStart(host, port, requests, std::move(cb), std::move(holder));
 }
 
+void WebSocket::send(const nlohmann::json &request) {
+    m_p->send(request.dump());
+}
+
 std::string WebSocket::streamName() const {
     return m_p->m_streamName;
 }
@@ -9,35 +9,80 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 
 #include <ftx_api/ftx_ws_client.h>
 #include <ftx_api/utils.h>
-#include <openssl/hmac.h>
+#include <ftx_api/ftx_json_decoder.h>
+#include <ftx_api/ftx_hmac_signer.h>
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/callable_traits.hpp>
 #include <variant>
+#include <unordered_map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <charconv>
 #include <iostream>
-#include <openssl/sha.h>
 
 namespace ftx {
 
 const char *FTX_FUTURES_WS_HOST = "ftx.com";
 const char *FTX_FUTURES_WS_PORT = "443";
 
+/// Maximum number of channel subscriptions carried by a single multiplexed connection
+static const std::size_t MAX_SUBSCRIPTIONS_PER_CONNECTION = 100;
+
+/// Callback of a single channel subscription, the frame view is valid only during the call
+using onFrameCB = std::function<bool(const char *fl, int ec, std::string errmsg, std::string_view frame)>;
+
+/// Reconnect backoff, the delay doubles with every failed attempt up to the maximum and is randomised by jitter
+static const int RECONNECT_BASE_DELAY_IN_MS = 500;
+static const int RECONNECT_MAX_DELAY_IN_MS = 30000;
+
+/// Multiplexed WebSocket connection shared by many channel subscriptions
+struct Connection {
+    std::weak_ptr<WebSocket> m_webSocket;
+    std::size_t m_numSubscriptions = 0;
+    bool m_loggedIn = false;
+    bool m_connected = false;
+
+    /// Incremented with every (re)connect, frames of older sockets are ignored
+    std::uint64_t m_generation = 0;
+    int m_reconnectAttempt = 0;
+    std::unique_ptr<boost::asio::steady_timer> m_reconnectTimer;
+};
+
+struct Subscription {
+    std::string m_streamName;
+    std::string m_pair;
+    Channel m_channel = Channel::ticker;
+    std::shared_ptr<Connection> m_connection;
+    onFrameCB m_callback;
+};
+
 struct WebSocketClient::P {
     boost::asio::io_context m_ioContext;
     std::string m_host = {FTX_FUTURES_WS_HOST};
     std::string m_port = {FTX_FUTURES_WS_PORT};
     onMessageReceivedCB m_onMessageCallback;
     std::map<WebSocket::handle, std::weak_ptr<WebSocket>> m_map;
+    bool m_multiplexed = true;
+    bool m_autoReconnect = true;
+    onConnectionStateCB m_connectionStateCB;
+    std::mt19937 m_random{std::random_device{}()};
+
+    /// Used by dispatchFrame on the IO thread only
+    std::string m_dispatchKey;
+    std::recursive_mutex m_subscriptionsLocker;
+    std::unordered_map<std::string, std::shared_ptr<Subscription>> m_subscriptions;
+    std::vector<std::shared_ptr<Connection>> m_connections;
     std::thread m_ioThread;
     std::atomic<bool> m_isRunning = false;
     onLogMessage m_logMessageCB;
     std::string m_apiKey;
-    std::string m_apiSecret;
+    std::unique_ptr<HMACSigner> m_signer;
     std::string m_subAccountName;
-    const EVP_MD *m_evp_md;
 
-    P() : m_evp_md(EVP_sha256()) {
+    P() {
         m_onMessageCallback = {};
     }
 
@@ -55,14 +100,19 @@ struct WebSocketClient::P {
         return std::make_pair(ec, std::move(msg));
     }
 
-    static nlohmann::json createRequest(const std::string &pair, Channel channel) {
+    static bool isAuthenticatedChannel(Channel channel) {
+        return channel == +Channel::orders || channel == +Channel::fills || channel == +Channel::ftxpay;
+    }
+
+    static nlohmann::json createRequest(const std::string &pair, Channel channel,
+                                        Operation operation = Operation::subscribe) {
 
         if (channel == +Channel::pingpong) {
             Ping request;
             return request.toJson();
         } else {
             ChannelSubscriptionRequest request;
-            request.m_op = Operation::subscribe;
+            request.m_op = operation;
             request.m_channel = channel;
             request.m_market = pair;
             return request.toJson();
@@ -75,17 +125,11 @@ struct WebSocketClient::P {
         request.m_subAccount = m_subAccountName;
         request.m_time = getMsTimestamp(currentTime()).count();
 
-        std::string authString(std::to_string(request.m_time));
-        authString.append("websocket_login");
-
-        unsigned char digest[SHA256_DIGEST_LENGTH];
-        unsigned int digestLength = 32;
+        char ts[20];
+        const auto tsEnd = std::to_chars(std::begin(ts), std::end(ts), request.m_time).ptr;
+        const auto sign = m_signer->sign({std::string_view(ts, tsEnd - ts), "websocket_login"});
 
-        HMAC(m_evp_md, m_apiSecret.data(), m_apiSecret.size(),
-             reinterpret_cast<const unsigned char *>(authString.data()),
-             authString.length(), digest, &digestLength);
-
-        request.m_sign = stringToHex(digest, sizeof(digest));
+        request.m_sign.assign(sign.data(), sign.size());
 
         return request.toJson();
     }
@@ -95,23 +139,10 @@ struct WebSocketClient::P {
         using argsTuple = typename boost::callable_traits::args<decltype(cb)>::type;
         using messageType = typename std::tuple_element<3, argsTuple>::type;
 
-        auto ws = std::make_shared<WebSocket>(m_ioContext, m_logMessageCB);
-        auto *h = ws.get();
-        std::weak_ptr<WebSocket> wp{ws};
-
         std::string streamName = composeStreamName(pair, channel);
-        std::vector<nlohmann::json> requests;
 
-        requests.push_back(createRequest(pair, channel));
-
-        if (channel == +Channel::orders || channel == +Channel::fills || channel == +Channel::ftxpay) {
-            requests.push_back(createAuthenticationRequest());
-        }
-
-        ws->setStreamName(streamName);
-
-        auto wsCallback = [this, streamName, requests, cb = std::move(cb)]
-                (const char *fl, int ec, std::string errmsg, const char *ptr, std::size_t size) -> bool {
+        onFrameCB frameCallback = [this, streamName, cb = std::move(cb)]
+                (const char *fl, int ec, std::string errmsg, std::string_view frame) -> bool {
             if (ec) {
                 try {
                     cb(fl, ec, std::move(errmsg), messageType{});
@@ -125,26 +156,8 @@ struct WebSocketClient::P {
                 return false;
             }
 
-            const nlohmann::json json = nlohmann::json::parse(ptr);
-
-            if (json.is_object() && isApiError(json)) {
-                auto error = constructError(json);
-                auto errorCode = error.first;
-                auto errorMsg = std::move(error.second);
-
-                try {
-                    messageType message{};
-                    return cb(MAKE_FILELINE, errorCode, std::move(errorMsg), std::move(message));
-                } catch (const std::exception &ex) {
-
-                    if (m_logMessageCB) {
-                        m_logMessageCB(LogSeverity::Error, std::format("{}: {}\n", MAKE_FILELINE, ex.what()));
-                    }
-                }
-            }
-
             try {
-                if (m_onMessageCallback) { m_onMessageCallback(streamName.c_str(), ptr, size); }
+                if (m_onMessageCallback) { m_onMessageCallback(streamName.c_str(), frame.data(), frame.size()); }
             } catch (const std::exception &ex) {
                 if (m_logMessageCB) {
                     m_logMessageCB(LogSeverity::Error, std::format("{}: {}\n", MAKE_FILELINE, ex.what()));
@@ -153,6 +166,33 @@ struct WebSocketClient::P {
 
             try {
                 messageType message;
+
+                if constexpr (std::is_same_v<messageType, Event>) {
+                    /// Streaming decoder first, the DOM is used only for channels and layouts it does not handle
+                    if (decodeEvent(frame, message)) {
+                        return cb(fl, ec, std::move(errmsg), std::move(message));
+                    }
+
+                    message = Event{};
+                }
+
+                const nlohmann::json json = nlohmann::json::parse(frame);
+
+                if (json.is_object() && isApiError(json)) {
+                    auto error = constructError(json);
+                    auto errorCode = error.first;
+                    auto errorMsg = std::move(error.second);
+
+                    try {
+                        return cb(MAKE_FILELINE, errorCode, std::move(errorMsg), messageType{});
+                    } catch (const std::exception &ex) {
+
+                        if (m_logMessageCB) {
+                            m_logMessageCB(LogSeverity::Error, std::format("{}: {}\n", MAKE_FILELINE, ex.what()));
+                        }
+                    }
+                }
+
                 message.fromJson(json);
                 return cb(fl, ec, std::move(errmsg), std::move(message));
             } catch (const std::exception &ex) {
@@ -164,6 +204,29 @@ struct WebSocketClient::P {
             return false;
         };
 
+        if (m_multiplexed) {
+            return startMultiplexedChannel(pair, channel, streamName, std::move(frameCallback));
+        }
+
+        auto ws = std::make_shared<WebSocket>(m_ioContext, m_logMessageCB);
+        auto *h = ws.get();
+        std::weak_ptr<WebSocket> wp{ws};
+
+        std::vector<nlohmann::json> requests;
+
+        if (isAuthenticatedChannel(channel)) {
+            requests.push_back(createAuthenticationRequest());
+        }
+
+        requests.push_back(createRequest(pair, channel));
+
+        ws->setStreamName(streamName);
+
+        auto wsCallback = [this, frameCallback = std::move(frameCallback)]
+                (const char *fl, int ec, std::string errmsg, std::string_view frame) -> bool {
+            return frameCallback(fl, ec, std::move(errmsg), frame);
+        };
+
         h->start(
                 m_host, m_port, requests, std::move(wsCallback), std::move(ws)
         );
@@ -175,6 +238,368 @@ struct WebSocketClient::P {
         return h;
     }
 
+    WebSocket::handle startMultiplexedChannel(const std::string &pair, Channel channel, const std::string &streamName,
+                                              onFrameCB frameCallback) {
+        std::lock_guard<std::recursive_mutex> lk(m_subscriptionsLocker);
+
+        removeDeadConnections();
+
+        std::shared_ptr<Connection> connection;
+
+        for (const auto &c: m_connections) {
+            if (c->m_numSubscriptions < MAX_SUBSCRIPTIONS_PER_CONNECTION) {
+                connection = c;
+                break;
+            }
+        }
+
+        std::vector<nlohmann::json> requests;
+
+        if (isAuthenticatedChannel(channel) && !(connection && connection->m_loggedIn)) {
+            requests.push_back(createAuthenticationRequest());
+        }
+
+        requests.push_back(createRequest(pair, channel));
+
+        auto subscription = std::make_shared<Subscription>();
+        subscription->m_streamName = streamName;
+        subscription->m_pair = pair;
+        subscription->m_channel = channel;
+        subscription->m_callback = std::move(frameCallback);
+
+        if (!connection) {
+            connection = std::make_shared<Connection>();
+            m_connections.push_back(connection);
+            connect(connection, requests);
+        } else if (auto ws = connection->m_webSocket.lock()) {
+            for (const auto &request: requests) {
+                ws->send(request);
+            }
+        }
+
+        /// When the connection is just being re-established the subscription is replayed by reconnect()
+
+        if (isAuthenticatedChannel(channel)) {
+            connection->m_loggedIn = true;
+        }
+
+        connection->m_numSubscriptions++;
+        subscription->m_connection = connection;
+        m_subscriptions.insert_or_assign(streamName, subscription);
+
+        return subscription.get();
+    }
+
+    void connect(const std::shared_ptr<Connection> &connection, const std::vector<nlohmann::json> &requests) {
+        auto ws = std::make_shared<WebSocket>(m_ioContext, m_logMessageCB);
+        ws->setStreamName("multiplex");
+        connection->m_webSocket = ws;
+        connection->m_connected = false;
+
+        const auto generation = ++connection->m_generation;
+        auto *h = ws.get();
+
+        h->start(
+                m_host, m_port, requests,
+                [this, wc = std::weak_ptr<Connection>(connection), generation]
+                        (const char *fl, int ec, std::string errmsg, std::string_view frame) -> bool {
+                    return dispatchFrame(wc.lock(), generation, fl, ec, std::move(errmsg), frame);
+                },
+                std::move(ws)
+        );
+    }
+
+    [[nodiscard]] std::vector<std::string> streamNames(const std::shared_ptr<Connection> &connection) const {
+        std::vector<std::string> retVal;
+
+        for (const auto &[streamName, subscription]: m_subscriptions) {
+            if (subscription->m_connection == connection) {
+                retVal.push_back(streamName);
+            }
+        }
+
+        return retVal;
+    }
+
+    void notifyConnectionState(bool connected, const std::vector<std::string> &streamNames) {
+        if (!m_connectionStateCB || streamNames.empty()) {
+            return;
+        }
+
+        try {
+            m_connectionStateCB(connected, streamNames);
+        } catch (const std::exception &ex) {
+            if (m_logMessageCB) {
+                m_logMessageCB(LogSeverity::Error, std::format("{}: {}\n", MAKE_FILELINE, ex.what()));
+            }
+        }
+    }
+
+    void scheduleReconnect(const std::shared_ptr<Connection> &connection) {
+        const auto exponent = std::min(connection->m_reconnectAttempt++, 16);
+        const auto backoff = std::min<std::int64_t>(static_cast<std::int64_t>(RECONNECT_BASE_DELAY_IN_MS) << exponent,
+                                                    RECONNECT_MAX_DELAY_IN_MS);
+        std::uniform_int_distribution<std::int64_t> jitter(backoff / 2, backoff);
+        const auto delay = std::chrono::milliseconds(jitter(m_random));
+
+        if (m_logMessageCB) {
+            m_logMessageCB(LogSeverity::Warning,
+                           std::format("WebSocket connection lost, reconnecting in {} ms (attempt {})",
+                                       delay.count(), connection->m_reconnectAttempt));
+        }
+
+        connection->m_reconnectTimer = std::make_unique<boost::asio::steady_timer>(m_ioContext, delay);
+        connection->m_reconnectTimer->async_wait(
+                [this, wc = std::weak_ptr<Connection>(connection)](const boost::system::error_code &ec) {
+                    if (!ec) {
+                        reconnect(wc.lock());
+                    }
+                });
+    }
+
+    /// Open a new socket for the connection, log in again and replay all its subscriptions
+    void reconnect(const std::shared_ptr<Connection> &connection) {
+        std::lock_guard<std::recursive_mutex> lk(m_subscriptionsLocker);
+
+        if (!connection || connection->m_numSubscriptions == 0 ||
+            std::find(m_connections.begin(), m_connections.end(), connection) == m_connections.end()) {
+            return;
+        }
+
+        std::vector<nlohmann::json> requests;
+        connection->m_loggedIn = false;
+
+        for (const auto &[streamName, subscription]: m_subscriptions) {
+            if (subscription->m_connection != connection) {
+                continue;
+            }
+
+            if (isAuthenticatedChannel(subscription->m_channel) && !connection->m_loggedIn) {
+                requests.insert(requests.begin(), createAuthenticationRequest());
+                connection->m_loggedIn = true;
+            }
+
+            requests.push_back(createRequest(subscription->m_pair, subscription->m_channel));
+        }
+
+        connect(connection, requests);
+    }
+
+    void onConnectionLost(const std::shared_ptr<Connection> &connection, const char *fl, int ec,
+                          const std::string &errmsg) {
+
+        if (!m_autoReconnect) {
+            /// Notify and drop all subscriptions of the connection so they can be subscribed again
+            std::vector<std::shared_ptr<Subscription>> subscriptions;
+
+            {
+                std::lock_guard<std::recursive_mutex> lk(m_subscriptionsLocker);
+
+                for (auto it = m_subscriptions.begin(); it != m_subscriptions.end();) {
+                    if (it->second->m_connection == connection) {
+                        subscriptions.push_back(it->second);
+                        it = m_subscriptions.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+
+                connection->m_numSubscriptions = 0;
+            }
+
+            for (const auto &subscription: subscriptions) {
+                subscription->m_callback(fl, ec, errmsg, {});
+            }
+
+            return;
+        }
+
+        std::vector<std::string> names;
+
+        {
+            std::lock_guard<std::recursive_mutex> lk(m_subscriptionsLocker);
+
+            if (connection->m_numSubscriptions == 0) {
+                return;
+            }
+
+            if (m_logMessageCB) {
+                m_logMessageCB(LogSeverity::Error, std::format("{}: ec={}, errmsg: {}", fl ? fl : "", ec, errmsg));
+            }
+
+            connection->m_connected = false;
+            names = streamNames(connection);
+            scheduleReconnect(connection);
+        }
+
+        notifyConnectionState(false, names);
+    }
+
+    /// Demultiplex a frame received on a shared connection to the subscription by its channel and market
+    bool dispatchFrame(const std::shared_ptr<Connection> &connection, std::uint64_t generation, const char *fl,
+                       int ec, std::string errmsg, std::string_view frame) {
+
+        if (!connection) {
+            return false;
+        }
+
+        std::vector<std::string> reconnectedStreams;
+
+        {
+            std::lock_guard<std::recursive_mutex> lk(m_subscriptionsLocker);
+
+            if (connection->m_generation != generation) {
+                return false;
+            }
+
+            if (!ec && !connection->m_connected) {
+                /// The first frame received proves the connection is up again
+                connection->m_connected = true;
+                connection->m_reconnectAttempt = 0;
+                reconnectedStreams = streamNames(connection);
+            }
+        }
+
+        if (ec) {
+            onConnectionLost(connection, fl, ec, errmsg);
+            return false;
+        }
+
+        notifyConnectionState(true, reconnectedStreams);
+
+        /// Only the routing attributes are read here, the subscription decodes the rest
+        std::string_view type;
+        std::string_view channel;
+        std::string_view market;
+
+        if (!decodeEventHeader(frame, type, channel, market)) {
+            if (m_logMessageCB) {
+                m_logMessageCB(LogSeverity::Error, std::format("{}: malformed frame: {}\n", MAKE_FILELINE, frame));
+            }
+            return true;
+        }
+
+        if (channel.empty()) {
+            /// Frames without channel are login errors and pongs
+            if (type == "error") {
+                if (m_logMessageCB) {
+                    m_logMessageCB(LogSeverity::Error, std::format("{}: {}\n", MAKE_FILELINE, frame));
+                }
+
+                onLoginError(connection, frame);
+            }
+            return true;
+        }
+
+        /// Compose the stream name into a reused buffer, same format as composeStreamName
+        m_dispatchKey.clear();
+
+        if (!market.empty()) {
+            for (const char c: market) {
+                m_dispatchKey.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+            }
+
+            m_dispatchKey.push_back('@');
+        }
+
+        m_dispatchKey.append(channel);
+
+        std::shared_ptr<Subscription> subscription;
+
+        {
+            std::lock_guard<std::recursive_mutex> lk(m_subscriptionsLocker);
+            const auto it = m_subscriptions.find(m_dispatchKey);
+
+            if (it == m_subscriptions.end() || it->second->m_connection != connection) {
+                return true;
+            }
+
+            subscription = it->second;
+        }
+
+        if (!subscription->m_callback(fl, ec, std::move(errmsg), frame)) {
+            stopMultiplexedChannel(subscription.get());
+        }
+
+        return true;
+    }
+
+    /// A rejected login is reported without channel, the authenticated subscriptions of the connection get the error
+    void onLoginError(const std::shared_ptr<Connection> &connection, std::string_view frame) {
+        int errorCode = 0;
+        std::string errorMsg;
+
+        try {
+            const auto json = nlohmann::json::parse(frame);
+            readValue<int>(json, "code", errorCode);
+            readValue<std::string>(json, "msg", errorMsg);
+        } catch (const std::exception &) {
+            errorMsg = frame;
+        }
+
+        std::vector<std::shared_ptr<Subscription>> subscriptions;
+
+        {
+            std::lock_guard<std::recursive_mutex> lk(m_subscriptionsLocker);
+
+            /// Login is sent again with the next authenticated subscription
+            connection->m_loggedIn = false;
+
+            for (const auto &[name, subscription]: m_subscriptions) {
+                if (subscription->m_connection == connection && isAuthenticatedChannel(subscription->m_channel)) {
+                    subscriptions.push_back(subscription);
+                }
+            }
+        }
+
+        for (const auto &subscription: subscriptions) {
+            if (!subscription->m_callback(MAKE_FILELINE, errorCode != 0 ? errorCode : -1, errorMsg, {})) {
+                stopMultiplexedChannel(subscription.get());
+            }
+        }
+    }
+
+    void stopMultiplexedChannel(WebSocket::handle h) {
+        std::lock_guard<std::recursive_mutex> lk(m_subscriptionsLocker);
+
+        for (auto it = m_subscriptions.begin(); it != m_subscriptions.end(); ++it) {
+            if (it->second.get() != h) {
+                continue;
+            }
+
+            const auto subscription = it->second;
+            m_subscriptions.erase(it);
+            subscription->m_connection->m_numSubscriptions--;
+
+            if (auto ws = subscription->m_connection->m_webSocket.lock()) {
+                if (subscription->m_connection->m_numSubscriptions != 0) {
+                    ws->send(createRequest(subscription->m_pair, subscription->m_channel, Operation::unsubscribe));
+                }
+            }
+
+            break;
+        }
+
+        removeDeadConnections();
+    }
+
+    /// Close connections without subscriptions, a connection which is being re-established is kept
+    void removeDeadConnections() {
+        std::lock_guard<std::recursive_mutex> lk(m_subscriptionsLocker);
+
+        for (auto it = m_connections.begin(); it != m_connections.end();) {
+            if ((*it)->m_numSubscriptions == 0) {
+                if (const auto ws = (*it)->m_webSocket.lock()) {
+                    ws->stop();
+                }
+
+                it = m_connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
     template<typename F>
     void stopChannelImpl(WebSocket::handle h, F f) {
         auto it = m_map.find(h);
@@ -190,6 +615,10 @@ struct WebSocketClient::P {
     }
 
     void stopChannel(WebSocket::handle h) {
+        if (m_multiplexed) {
+            return stopMultiplexedChannel(h);
+        }
+
         return stopChannelImpl(h, [](const auto &sp) { sp->stop(); });
     }
 
@@ -205,6 +634,19 @@ struct WebSocketClient::P {
     }
 
     void unsubscribeAll() {
+        {
+            std::lock_guard<std::recursive_mutex> lk(m_subscriptionsLocker);
+
+            for (const auto &connection: m_connections) {
+                if (auto ws = connection->m_webSocket.lock()) {
+                    ws->stop();
+                }
+            }
+
+            m_connections.clear();
+            m_subscriptions.clear();
+        }
+
         return unsubscribe_all_impl([](const auto &sp) { sp->stop(); });
     }
 
@@ -222,7 +664,7 @@ struct WebSocketClient::P {
 WebSocketClient::WebSocketClient(const std::string &apiKey, const std::string &apiSecret,
                                  const std::string &subAccountName) : m_p(spimpl::make_unique_impl<P>()) {
     m_p->m_apiKey = apiKey;
-    m_p->m_apiSecret = apiSecret;
+    m_p->m_signer = std::make_unique<HMACSigner>(apiSecret);
     m_p->m_subAccountName = subAccountName;
 }
 
@@ -317,12 +759,40 @@ void WebSocketClient::unsubscribeAll() {
     return m_p->unsubscribeAll();
 }
 
+void WebSocketClient::setMultiplexed(bool multiplexed) {
+    m_p->m_multiplexed = multiplexed;
+}
+
+bool WebSocketClient::isMultiplexed() const {
+    return m_p->m_multiplexed;
+}
+
+void WebSocketClient::setAutoReconnect(bool autoReconnect) {
+    m_p->m_autoReconnect = autoReconnect;
+}
+
+void WebSocketClient::setConnectionStateCallback(const onConnectionStateCB &onConnectionStateCB) {
+    std::lock_guard<std::recursive_mutex> lk(m_p->m_subscriptionsLocker);
+    m_p->m_connectionStateCB = onConnectionStateCB;
+}
+
 void WebSocketClient::setLoggerCallback(const onLogMessage &onLogMessageCB) {
     m_p->m_logMessageCB = onLogMessageCB;
 }
 
 WebSocket::handle WebSocketClient::findStream(const std::string &streamName) {
 
+    if (m_p->m_multiplexed) {
+        std::lock_guard<std::recursive_mutex> lk(m_p->m_subscriptionsLocker);
+        const auto it = m_p->m_subscriptions.find(streamName);
+
+        if (it != m_p->m_subscriptions.end()) {
+            return it->second.get();
+        }
+
+        return nullptr;
+    }
+
     m_p->removeDeadWebsockets();
 
     for (const auto &el: m_p->m_map) {
@@ -379,6 +849,34 @@ WebSocket::handle WebSocketClient::markets(const std::string &pair, onEventCB cb
     return m_p->startChannel(pair, Channel::markets, std::move(cb));
 }
 
+WebSocket::handle WebSocketClient::orderBook(const std::string &pair, onEventCB cb) {
+    return m_p->startChannel(pair, Channel::orderbook, std::move(cb));
+}
+
+WebSocket::handle WebSocketClient::trades(const std::string &pair, onEventCB cb) {
+    return m_p->startChannel(pair, Channel::trades, std::move(cb));
+}
+
+void WebSocketClient::resubscribe(const std::string &pair, Channel channel) {
+    std::shared_ptr<WebSocket> ws;
+
+    if (m_p->m_multiplexed) {
+        std::lock_guard<std::recursive_mutex> lk(m_p->m_subscriptionsLocker);
+        const auto it = m_p->m_subscriptions.find(composeStreamName(pair, channel));
+
+        if (it != m_p->m_subscriptions.end()) {
+            ws = it->second->m_connection->m_webSocket.lock();
+        }
+    } else if (const auto h = findStream(composeStreamName(pair, channel))) {
+        ws = m_p->m_map[h].lock();
+    }
+
+    if (ws) {
+        ws->send(P::createRequest(pair, channel, Operation::unsubscribe));
+        ws->send(P::createRequest(pair, channel));
+    }
+}
+
 WebSocket::handle WebSocketClient::orders(onEventCB cb) {
     return m_p->startChannel("", Channel::orders, std::move(cb));
 }
@@ -9,25 +9,291 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 
 #include <ftx_api/ftx_ws_stream_manager.h>
 #include <ftx_api/ftx_ws_client.h>
+#include <ftx_api/ftx_rest_client.h>
+#include <ftx_api/ftx_order_store.h>
+#include <ftx_api/ftx_ticker_slot.h>
 #include <mutex>
-
-using namespace std::chrono_literals;
+#include <condition_variable>
+#include <atomic>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <future>
+#include <thread>
+#include <utility>
+#include <algorithm>
 
 namespace ftx {
 
+/// Maximum number of simultaneously tracked tickers
+static const std::size_t MAX_TICKER_SLOTS = 1024;
+
+/// Reconcile window starts this much before the disconnect was detected, covers the ping expiry delay
+static const std::int64_t RECONCILE_MARGIN_IN_S = 30;
+
+/// Period of the position book reconciliation with REST
+static const std::int64_t POSITIONS_RECONCILE_INTERVAL_IN_S = 60;
+
+/// Number of attempts to load a position snapshot not outdated by fills received meanwhile
+static const int MAX_POSITIONS_LOAD_ATTEMPTS = 3;
+
 struct WSStreamManager::P {
     std::unique_ptr<WebSocketClient> m_wsClient;
-    int m_timeout = 30;
-    mutable std::recursive_mutex m_tickerLocker;
-    mutable std::recursive_mutex m_fillsLocker;
-    mutable std::recursive_mutex m_ordersLocker;
-    std::map<std::string, TickerData> m_tickPrices;
-    std::vector<FillData> m_fillsData;
-    std::vector<OrderData> m_ordersData;
+    std::atomic<int> m_timeout = 30;
+    mutable std::mutex m_tickerLocker;
+    mutable std::mutex m_fillsLocker;
+    mutable std::mutex m_ordersLocker;
+    std::condition_variable m_tickerCondition;
+    std::condition_variable m_fillsCondition;
+
+    /// Set when FTX acknowledged the fills subscription, fills are delivered from then on
+    bool m_fillsSubscribed = false;
+    std::condition_variable m_ordersCondition;
+
+    /// Incremented when the Orders Stream reports an error (e.g. a rejected login), waiting readers give up
+    std::uint64_t m_ordersStreamErrors = 0;
+    mutable std::shared_mutex m_tickerIndexLocker;
+    std::unordered_map<std::string, std::size_t> m_tickerIndex;
+    std::unique_ptr<TickerSlot[]> m_tickerSlots = std::make_unique<TickerSlot[]>(MAX_TICKER_SLOTS);
+    mutable std::mutex m_orderBooksLocker;
+    std::condition_variable m_orderBooksCondition;
+    std::unordered_map<std::string, OrderBook> m_orderBooks;
+    mutable std::mutex m_barBuildersLocker;
+    std::unordered_map<std::string, BarBuilder> m_barBuilders;
+    MarketCache m_marketCache;
+    PositionBook m_positionBook;
+    std::mutex m_positionsThreadLocker;
+    std::condition_variable m_positionsThreadCondition;
+    std::thread m_positionsThread;
+    bool m_stopPositionsThread = false;
+    std::atomic<bool> m_positionBookRunning = false;
+    FillStore m_fillStore;
+    OrderStore m_orderStore;
+    std::shared_ptr<RESTClient> m_restClient;
+    std::atomic<std::int64_t> m_disconnectedAt = 0;
+    std::mutex m_reconcileLocker;
+    std::future<void> m_reconcileFuture;
+    bool m_reconcileRunning = false;
+
+    /// Start of the window requested by a reconnect while a reconciliation was running, 0 if none
+    std::int64_t m_pendingReconcileFrom = 0;
     onLogMessage m_logMessageCB;
 
-    explicit P(const std::string &apiKey, const std::string &apiSecret, const std::string &subAccountName) {
+    P(const std::string &apiKey, const std::string &apiSecret, const std::string &subAccountName,
+      std::shared_ptr<RESTClient> restClient) : m_restClient(std::move(restClient)) {
         m_wsClient = std::make_unique<WebSocketClient>(apiKey, apiSecret, subAccountName);
+
+        m_wsClient->setConnectionStateCallback([this](bool connected, const std::vector<std::string> &streamNames) {
+            onConnectionState(connected, streamNames);
+        });
+    }
+
+    void onConnectionState(bool connected, const std::vector<std::string> &streamNames) {
+        const std::unordered_set<std::string> names(streamNames.begin(), streamNames.end());
+        const bool hasPrivateStreams = names.contains(WebSocketClient::composeStreamName("", Channel::orders)) ||
+                                       names.contains(WebSocketClient::composeStreamName("", Channel::fills));
+
+        if (!connected) {
+            /// Prices are frozen while down, readers get nothing instead of a stale quote
+            {
+                std::shared_lock<std::shared_mutex> lk(m_tickerIndexLocker);
+
+                for (const auto &[pair, index]: m_tickerIndex) {
+                    if (names.contains(WebSocketClient::composeStreamName(pair, Channel::ticker))) {
+                        m_tickerSlots[index].m_stale.store(true, std::memory_order_release);
+                    }
+                }
+            }
+
+            {
+                /// Books are rebuilt from the partial sent after the subscriptions are replayed
+                std::lock_guard<std::mutex> lk(m_orderBooksLocker);
+
+                for (auto &[pair, orderBook]: m_orderBooks) {
+                    if (names.contains(WebSocketClient::composeStreamName(pair, Channel::orderbook))) {
+                        orderBook.clear();
+                    }
+                }
+            }
+
+            {
+                /// Trades sent while disconnected are lost, bars start again as partial ones
+                std::lock_guard<std::mutex> lk(m_barBuildersLocker);
+
+                for (auto &[pair, barBuilder]: m_barBuilders) {
+                    if (names.contains(WebSocketClient::composeStreamName(pair, Channel::trades))) {
+                        barBuilder.clear();
+                    }
+                }
+            }
+
+            if (names.contains(WebSocketClient::composeStreamName("", Channel::fills))) {
+                /// Fills are lost while down, readers fall back to REST until the book is reloaded
+                m_positionBook.clear();
+
+                std::lock_guard<std::mutex> lk(m_fillsLocker);
+                m_fillsSubscribed = false;
+            }
+
+            if (hasPrivateStreams) {
+                std::int64_t expected = 0;
+                m_disconnectedAt.compare_exchange_strong(expected, std::chrono::duration_cast<std::chrono::seconds>(
+                        currentTime().time_since_epoch()).count());
+
+                /// Order confirmations waiting for the stream fall back to REST
+                {
+                    std::lock_guard<std::mutex> lk(m_ordersLocker);
+                }
+                m_ordersCondition.notify_all();
+            }
+
+            return;
+        }
+
+        if (names.contains(WebSocketClient::composeStreamName("", Channel::fills))) {
+            /// Fills are received again, the book is reloaded by the reconciliation below
+            m_positionBook.resume();
+        }
+
+        const auto disconnectedAt = m_disconnectedAt.exchange(0);
+
+        if (hasPrivateStreams && disconnectedAt != 0) {
+            /// Orders and fills sent while disconnected are lost, fetch them via REST off the IO thread. The IO thread
+            /// never waits, a window requested while a reconciliation is running is merged and done by the same task.
+            const auto from = disconnectedAt - RECONCILE_MARGIN_IN_S;
+            std::lock_guard<std::mutex> lk(m_reconcileLocker);
+
+            if (m_reconcileRunning) {
+                m_pendingReconcileFrom = m_pendingReconcileFrom == 0 ? from : std::min(m_pendingReconcileFrom, from);
+                return;
+            }
+
+            m_reconcileRunning = true;
+
+            /// The previous task has already finished, replacing its future does not block
+            m_reconcileFuture = std::async(std::launch::async, [this, from] {
+                runReconcile(from);
+            });
+        }
+    }
+
+    void runReconcile(std::int64_t from) {
+        for (;;) {
+            reconcile(from);
+
+            std::lock_guard<std::mutex> lk(m_reconcileLocker);
+
+            if (m_pendingReconcileFrom == 0) {
+                m_reconcileRunning = false;
+                return;
+            }
+
+            from = std::exchange(m_pendingReconcileFrom, 0);
+        }
+    }
+
+    void reconcile(std::int64_t from) {
+        try {
+            const auto fills = m_restClient->getFills(from);
+
+            {
+                std::lock_guard<std::mutex> lk(m_fillsLocker);
+
+                /// REST returns the newest first
+                for (auto it = fills.rbegin(); it != fills.rend(); ++it) {
+                    m_fillStore.add(*it);
+                }
+            }
+
+            m_fillsCondition.notify_all();
+
+            const auto orders = m_restClient->getOrderHistory(from);
+
+            {
+                std::lock_guard<std::mutex> lk(m_ordersLocker);
+
+                for (auto it = orders.rbegin(); it != orders.rend(); ++it) {
+                    m_orderStore.add(*it);
+                }
+            }
+
+            m_ordersCondition.notify_all();
+
+            if (m_positionBookRunning) {
+                reloadPositions();
+            }
+
+            if (m_logMessageCB) {
+                m_logMessageCB(LogSeverity::Info,
+                               std::format("Reconciled {} fills and {} orders after reconnect", fills.size(),
+                                           orders.size()));
+            }
+        }
+        catch (const std::exception &e) {
+            if (m_logMessageCB) {
+                m_logMessageCB(LogSeverity::Error, std::format("{}: {}\n", MAKE_FILELINE, e.what()));
+            }
+        }
+    }
+
+    /// @return False if each loaded snapshot was outdated by fills received meanwhile
+    bool reloadPositions() {
+        for (int i = 0; i < MAX_POSITIONS_LOAD_ATTEMPTS; i++) {
+            const auto sequence = m_positionBook.sequence();
+
+            /// A joined or cached snapshot may have been requested before the sequence was read
+            if (m_positionBook.load(m_restClient->getPositions(true), sequence)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void reconcilePositions() {
+        std::unique_lock<std::mutex> lk(m_positionsThreadLocker);
+
+        while (!m_positionsThreadCondition.wait_for(lk, std::chrono::seconds(POSITIONS_RECONCILE_INTERVAL_IN_S),
+                                                    [this] { return m_stopPositionsThread; })) {
+            /// While down the book is suspended, it is reloaded by the reconciliation after the reconnect
+            if (m_disconnectedAt != 0) {
+                continue;
+            }
+
+            lk.unlock();
+
+            try {
+                if (!reloadPositions() && m_logMessageCB) {
+                    m_logMessageCB(LogSeverity::Warning, "Position book not reconciled, fills received meanwhile");
+                }
+            }
+            catch (const std::exception &e) {
+                if (m_logMessageCB) {
+                    m_logMessageCB(LogSeverity::Error, std::format("{}: {}\n", MAKE_FILELINE, e.what()));
+                }
+            }
+
+            lk.lock();
+        }
+    }
+
+    std::size_t resolveTickerIndex(const std::string &pair) {
+        {
+            std::shared_lock<std::shared_mutex> lk(m_tickerIndexLocker);
+            const auto it = m_tickerIndex.find(pair);
+
+            if (it != m_tickerIndex.end()) {
+                return it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lk(m_tickerIndexLocker);
+
+        if (m_tickerIndex.size() >= MAX_TICKER_SLOTS) {
+            throw std::runtime_error(std::format("Too many ticker streams, maximum is {}", MAX_TICKER_SLOTS).c_str());
+        }
+
+        return m_tickerIndex.try_emplace(pair, m_tickerIndex.size()).first->second;
     }
 
     static std::string formatMessage(const Event &msg) {
@@ -51,28 +317,72 @@ struct WSStreamManager::P {
 };
 
 WSStreamManager::WSStreamManager(const std::string &apiKey, const std::string &apiSecret,
-                                 const std::string &subAccountName) : m_p(
-        spimpl::make_unique_impl<P>(apiKey, apiSecret, subAccountName)) {
+                                 const std::string &subAccountName, std::shared_ptr<RESTClient> restClient) : m_p(
+        spimpl::make_unique_impl<P>(apiKey, apiSecret, subAccountName, std::move(restClient))) {
 }
 
 WSStreamManager::~WSStreamManager() {
+    m_p->m_wsClient->setConnectionStateCallback({});
+
+    {
+        std::lock_guard<std::mutex> lk(m_p->m_positionsThreadLocker);
+        m_p->m_stopPositionsThread = true;
+    }
+
+    m_p->m_positionsThreadCondition.notify_all();
+
+    if (m_p->m_positionsThread.joinable()) {
+        m_p->m_positionsThread.join();
+    }
+
     m_p->m_wsClient->unsubscribeAll();
+
+    std::future<void> reconcileFuture;
+
+    {
+        /// The running task takes the lock when it finishes, it must not be held while waiting
+        std::lock_guard<std::mutex> lk(m_p->m_reconcileLocker);
+        m_p->m_pendingReconcileFrom = 0;
+        reconcileFuture = std::move(m_p->m_reconcileFuture);
+    }
+
+    if (reconcileFuture.valid()) {
+        reconcileFuture.wait();
+    }
+
+    /// Each mutex is taken so that a reader between its predicate check and the wait cannot miss the wake-up
+    const auto wakeUp = [](std::mutex &locker, std::condition_variable &condition) {
+        {
+            std::lock_guard<std::mutex> lk(locker);
+        }
+
+        condition.notify_all();
+    };
+
     m_p->m_timeout = 0;
+    wakeUp(m_p->m_tickerLocker, m_p->m_tickerCondition);
+    wakeUp(m_p->m_orderBooksLocker, m_p->m_orderBooksCondition);
+    wakeUp(m_p->m_fillsLocker, m_p->m_fillsCondition);
+    wakeUp(m_p->m_ordersLocker, m_p->m_ordersCondition);
 }
-void
-WSStreamManager::subscribeTickerStream(const std::string &pair, bool force) {
 
+std::size_t WSStreamManager::subscribeTickerStream(const std::string &pair, bool force) {
+
+    const auto index = m_p->resolveTickerIndex(pair);
     auto handle = m_p->m_wsClient->findStream(WebSocketClient::composeStreamName(pair, Channel::ticker));
 
     if (handle && force) {
         m_p->m_wsClient->unsubscribe(handle);
     } else if (handle) {
-        return;
+        return index;
     }
 
-    handle = m_p->m_wsClient->ticker(pair, [&](const char *fl, int ec, const std::string &errmsg,
+    TickerSlot *slot = &m_p->m_tickerSlots[index];
+
+    handle = m_p->m_wsClient->ticker(pair, [this, slot](const char *fl, int ec, const std::string &errmsg,
                                                const Event &msg) -> bool {
                                          if (ec) {
+                                             slot->m_stale.store(true, std::memory_order_release);
 
                                              if (m_p->m_logMessageCB) {
                                                  const auto msgString = std::format(
@@ -83,11 +393,14 @@ WSStreamManager::subscribeTickerStream(const std::string &pair, bool force) {
                                              return false;
                                          }
 
-                                         std::lock_guard<std::recursive_mutex> lk(m_p->m_tickerLocker);
                                          const TickerData *td = std::get_if<TickerData>(&msg.m_eventData);
 
                                          if (td != nullptr) {
-                                             m_p->m_tickPrices.insert_or_assign(msg.m_subscriptionResponse.m_market, *td);
+                                             if (slot->store(*td)) {
+                                                 /// Wake up readers waiting for the very first tick only
+                                                 std::lock_guard<std::mutex> lk(m_p->m_tickerLocker);
+                                                 m_p->m_tickerCondition.notify_all();
+                                             }
                                          } else {
                                              m_p->m_logMessageCB(LogSeverity::Info, m_p->formatMessage(msg));
                                          }
@@ -98,6 +411,163 @@ WSStreamManager::subscribeTickerStream(const std::string &pair, bool force) {
     if (!m_p->m_wsClient->isRunning()) {
         m_p->m_wsClient->run();
     }
+
+    return index;
+}
+
+void WSStreamManager::subscribeOrderBookStream(const std::string &pair, bool force) {
+    auto handle = m_p->m_wsClient->findStream(WebSocketClient::composeStreamName(pair, Channel::orderbook));
+
+    if (handle && force) {
+        m_p->m_wsClient->unsubscribe(handle);
+    } else if (handle) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(m_p->m_orderBooksLocker);
+        m_p->m_orderBooks[pair].clear();
+    }
+
+    handle = m_p->m_wsClient->orderBook(pair, [this, pair](const char *fl, int ec, const std::string &errmsg,
+                                                           const Event &msg) -> bool {
+                                            if (ec) {
+                                                {
+                                                    std::lock_guard<std::mutex> lk(m_p->m_orderBooksLocker);
+                                                    m_p->m_orderBooks[pair].clear();
+                                                }
+
+                                                if (m_p->m_logMessageCB) {
+                                                    const auto msgString = std::format(
+                                                            "orderbook: fl={}, ec={}, errmsg: {}", fl, ec, errmsg);
+                                                    m_p->m_logMessageCB(LogSeverity::Error, msgString);
+                                                }
+
+                                                return false;
+                                            }
+
+                                            const OrderBookData *obd = std::get_if<OrderBookData>(&msg.m_eventData);
+
+                                            if (obd != nullptr) {
+                                                bool applied;
+
+                                                {
+                                                    std::lock_guard<std::mutex> lk(m_p->m_orderBooksLocker);
+                                                    applied = m_p->m_orderBooks[pair].apply(*obd);
+                                                }
+
+                                                if (!applied) {
+                                                    if (m_p->m_logMessageCB) {
+                                                        m_p->m_logMessageCB(LogSeverity::Warning, std::format(
+                                                                "orderbook: checksum mismatch, resync {}", pair));
+                                                    }
+
+                                                    m_p->m_wsClient->resubscribe(pair, Channel::orderbook);
+                                                } else if (obd->m_action == +OperationResponse::partial) {
+                                                    m_p->m_orderBooksCondition.notify_all();
+                                                }
+                                            } else {
+                                                m_p->m_logMessageCB(LogSeverity::Info, m_p->formatMessage(msg));
+                                            }
+                                            return true;
+                                        }
+    );
+
+    if (!m_p->m_wsClient->isRunning()) {
+        m_p->m_wsClient->run();
+    }
+}
+
+void WSStreamManager::subscribeTradesStream(const std::string &pair, bool force) {
+    auto handle = m_p->m_wsClient->findStream(WebSocketClient::composeStreamName(pair, Channel::trades));
+
+    if (handle && force) {
+        m_p->m_wsClient->unsubscribe(handle);
+    } else if (handle) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(m_p->m_barBuildersLocker);
+        m_p->m_barBuilders[pair].clear();
+    }
+
+    handle = m_p->m_wsClient->trades(pair, [this, pair](const char *fl, int ec, const std::string &errmsg,
+                                                        const Event &msg) -> bool {
+                                         if (ec) {
+                                             {
+                                                 std::lock_guard<std::mutex> lk(m_p->m_barBuildersLocker);
+                                                 m_p->m_barBuilders[pair].clear();
+                                             }
+
+                                             if (m_p->m_logMessageCB) {
+                                                 const auto msgString = std::format(
+                                                         "trades: fl={}, ec={}, errmsg: {}", fl, ec, errmsg);
+                                                 m_p->m_logMessageCB(LogSeverity::Error, msgString);
+                                             }
+
+                                             return false;
+                                         }
+
+                                         const TradesData *trd = std::get_if<TradesData>(&msg.m_eventData);
+
+                                         if (trd != nullptr) {
+                                             std::lock_guard<std::mutex> lk(m_p->m_barBuildersLocker);
+                                             auto &barBuilder = m_p->m_barBuilders[pair];
+
+                                             for (const auto &trade: trd->m_trades) {
+                                                 barBuilder.add(trade);
+                                             }
+                                         } else {
+                                             m_p->m_logMessageCB(LogSeverity::Info, m_p->formatMessage(msg));
+                                         }
+                                         return true;
+                                     }
+    );
+
+    if (!m_p->m_wsClient->isRunning()) {
+        m_p->m_wsClient->run();
+    }
+}
+
+void WSStreamManager::subscribeMarketsStream(bool force) {
+    auto handle = m_p->m_wsClient->findStream(WebSocketClient::composeStreamName("", Channel::markets));
+
+    if (handle && force) {
+        m_p->m_wsClient->unsubscribe(handle);
+    } else if (handle) {
+        return;
+    }
+
+    m_p->m_marketCache.load(m_p->m_restClient->getMarkets());
+
+    handle = m_p->m_wsClient->markets("", [this](const char *fl, int ec, const std::string &errmsg,
+                                                 const Event &msg) -> bool {
+                                          if (ec) {
+
+                                              if (m_p->m_logMessageCB) {
+                                                  const auto msgString = std::format(
+                                                          "markets: fl={}, ec={}, errmsg: {}", fl, ec, errmsg);
+                                                  m_p->m_logMessageCB(LogSeverity::Error, msgString);
+                                              }
+
+                                              return false;
+                                          }
+
+                                          const MarketsData *md = std::get_if<MarketsData>(&msg.m_eventData);
+
+                                          if (md != nullptr) {
+                                              m_p->m_marketCache.update(*md);
+                                          } else {
+                                              m_p->m_logMessageCB(LogSeverity::Info, m_p->formatMessage(msg));
+                                          }
+                                          return true;
+                                      }
+    );
+
+    if (!m_p->m_wsClient->isRunning()) {
+        m_p->m_wsClient->run();
+    }
 }
 
 void WSStreamManager::subscribeOrdersStream(bool force) {
@@ -119,14 +589,23 @@ void WSStreamManager::subscribeOrdersStream(bool force) {
                                                  m_p->m_logMessageCB(LogSeverity::Error, msgString);
                                              }
 
+                                             {
+                                                 std::lock_guard<std::mutex> lk(m_p->m_ordersLocker);
+                                                 m_p->m_ordersStreamErrors++;
+                                             }
+                                             m_p->m_ordersCondition.notify_all();
+
                                              return false;
                                          }
 
-                                         std::lock_guard<std::recursive_mutex> lk(m_p->m_ordersLocker);
                                          const OrderData *od = std::get_if<OrderData>(&msg.m_eventData);
 
                                          if (od != nullptr) {
-                                             m_p->m_ordersData.push_back(*od);
+                                             {
+                                                 std::lock_guard<std::mutex> lk(m_p->m_ordersLocker);
+                                                 m_p->m_orderStore.add(*od);
+                                             }
+                                             m_p->m_ordersCondition.notify_all();
                                          } else {
                                              m_p->m_logMessageCB(LogSeverity::Info, m_p->formatMessage(msg));
                                          }
@@ -148,6 +627,11 @@ void WSStreamManager::subscribeFillsStream(bool force) {
         return;
     }
 
+    {
+        std::lock_guard<std::mutex> lk(m_p->m_fillsLocker);
+        m_p->m_fillsSubscribed = false;
+    }
+
     handle = m_p->m_wsClient->fills([&](const char *fl, int ec, const std::string &errmsg,
                                         const Event &msg) -> bool {
                                         if (ec) {
@@ -161,12 +645,25 @@ void WSStreamManager::subscribeFillsStream(bool force) {
                                             return false;
                                         }
 
-                                        std::lock_guard<std::recursive_mutex> lk(m_p->m_fillsLocker);
                                         const FillData *fd = std::get_if<FillData>(&msg.m_eventData);
 
                                         if (fd != nullptr) {
-                                            m_p->m_fillsData.push_back(*fd);
+                                            {
+                                                std::lock_guard<std::mutex> lk(m_p->m_fillsLocker);
+
+                                                if (m_p->m_fillStore.add(*fd)) {
+                                                    m_p->m_positionBook.apply(*fd);
+                                                }
+                                            }
+                                            m_p->m_fillsCondition.notify_all();
                                         } else {
+                                            if (msg.m_subscriptionResponse.m_type == +OperationResponse::subscribed) {
+                                                {
+                                                    std::lock_guard<std::mutex> lk(m_p->m_fillsLocker);
+                                                    m_p->m_fillsSubscribed = true;
+                                                }
+                                                m_p->m_fillsCondition.notify_all();
+                                            }
 
                                             m_p->m_logMessageCB(LogSeverity::Info, m_p->formatMessage(msg));
                                         }
@@ -179,6 +676,34 @@ void WSStreamManager::subscribeFillsStream(bool force) {
     }
 }
 
+void WSStreamManager::subscribePositionBook() {
+    std::lock_guard<std::mutex> lk(m_p->m_positionsThreadLocker);
+
+    if (m_p->m_positionsThread.joinable()) {
+        return;
+    }
+
+    /// Subscribe first and wait for the acknowledgement so that no fill is missed between the snapshot and the stream
+    subscribeFillsStream();
+
+    {
+        std::unique_lock<std::mutex> lk(m_p->m_fillsLocker);
+
+        if (!m_p->m_fillsCondition.wait_for(lk, std::chrono::seconds(m_p->m_timeout), [&] {
+            return m_p->m_fillsSubscribed || m_p->m_timeout == 0;
+        }) || !m_p->m_fillsSubscribed) {
+            throw std::runtime_error("Cannot load positions, fills subscription not acknowledged");
+        }
+    }
+
+    if (!m_p->reloadPositions()) {
+        throw std::runtime_error("Cannot load positions, fills received meanwhile");
+    }
+
+    m_p->m_positionsThread = std::thread([this] { m_p->reconcilePositions(); });
+    m_p->m_positionBookRunning = true;
+}
+
 void WSStreamManager::setTimeout(int seconds) {
     m_p->m_timeout = seconds;
 }
@@ -194,73 +719,139 @@ void WSStreamManager::setLoggerCallback(const onLogMessage &onLogMessageCB) {
 
 std::optional<TickerData> WSStreamManager::readTickerData(const std::string &pair) {
 
-    int numTries = 0;
-    int maxNumTries = static_cast<int>(m_p->m_timeout / 0.01);
+    std::size_t index;
 
-    while (numTries <= maxNumTries) {
-        m_p->m_tickerLocker.lock();
-        const auto it = m_p->m_tickPrices.find(pair);
+    {
+        std::shared_lock<std::shared_mutex> lk(m_p->m_tickerIndexLocker);
+        const auto it = m_p->m_tickerIndex.find(pair);
 
-        if (it != m_p->m_tickPrices.end()) {
-            auto retVal = it->second;
-            m_p->m_tickerLocker.unlock();
-            return retVal;
+        if (it == m_p->m_tickerIndex.end()) {
+            return {};
         }
-        m_p->m_tickerLocker.unlock();
-        numTries++;
-        std::this_thread::sleep_for(10ms);
+
+        index = it->second;
+    }
+
+    return readTickerData(index);
+}
+
+std::optional<TickerData> WSStreamManager::readTickerData(std::size_t index) {
+
+    if (index >= MAX_TICKER_SLOTS) {
+        return {};
+    }
+
+    const TickerSlot &slot = m_p->m_tickerSlots[index];
+    TickerData retVal;
+
+    if (slot.m_stale.load(std::memory_order_acquire)) {
+        return {};
+    }
+
+    if (slot.load(retVal)) {
+        return retVal;
+    }
+
+    std::unique_lock<std::mutex> lk(m_p->m_tickerLocker);
+
+    if (m_p->m_tickerCondition.wait_for(lk, std::chrono::seconds(m_p->m_timeout), [&] {
+        return slot.load(retVal) || m_p->m_timeout == 0;
+    }) && m_p->m_timeout != 0) {
+        return retVal;
     }
 
     return {};
 }
 
-std::optional<FillData> WSStreamManager::readFillData(const Order &order) {
-    int numTries = 0;
-    int maxNumTries = static_cast<int>(m_p->m_timeout / 0.01);
-
-    while (numTries <= maxNumTries) {
-        m_p->m_fillsLocker.lock();
-        std::vector<FillData>::iterator it;
-
-        for (it = m_p->m_fillsData.begin(); it != m_p->m_fillsData.end(); it++) {
-            if ((*it).m_id == order.m_id || (*it).m_id == std::stoll(order.m_clientId)) {
-                FillData fillData = *it;
-                m_p->m_fillsData.erase(it);
-                m_p->m_fillsLocker.unlock();
-                return fillData;
-            }
-        }
+std::optional<OrderBook> WSStreamManager::readOrderBook(const std::string &pair) {
+
+    std::unique_lock<std::mutex> lk(m_p->m_orderBooksLocker);
+    const auto it = m_p->m_orderBooks.find(pair);
+
+    if (it == m_p->m_orderBooks.end()) {
+        return {};
+    }
+
+    /// Unlike the iterator the reference survives a rehash by a concurrent subscribe
+    const OrderBook &orderBook = it->second;
 
-        m_p->m_fillsLocker.unlock();
-        numTries++;
-        std::this_thread::sleep_for(3ms);
+    if (m_p->m_orderBooksCondition.wait_for(lk, std::chrono::seconds(m_p->m_timeout), [&] {
+        return orderBook.isValid() || m_p->m_timeout == 0;
+    }) && m_p->m_timeout != 0) {
+        return orderBook;
     }
 
     return {};
 }
 
+std::vector<Candle> WSStreamManager::readBars(const std::string &pair, std::int32_t resolutionInSecs,
+                                              std::int64_t from, std::int64_t to) const {
+
+    std::lock_guard<std::mutex> lk(m_p->m_barBuildersLocker);
+    const auto it = m_p->m_barBuilders.find(pair);
+
+    if (it == m_p->m_barBuilders.end()) {
+        return {};
+    }
+
+    return it->second.read(resolutionInSecs, from, to);
+}
+
+std::optional<Market> WSStreamManager::readMarket(const std::string &name) const {
+    return m_p->m_marketCache.find(name);
+}
+
+std::optional<Position> WSStreamManager::readPosition(const std::string &future) const {
+    return m_p->m_positionBook.find(future);
+}
+
+std::optional<FillData> WSStreamManager::readFillData(const Order &order) {
+
+    std::optional<FillData> retVal;
+    std::unique_lock<std::mutex> lk(m_p->m_fillsLocker);
+
+    m_p->m_fillsCondition.wait_for(lk, std::chrono::seconds(m_p->m_timeout), [&] {
+        retVal = m_p->m_fillStore.take(order);
+        return retVal || m_p->m_timeout == 0;
+    });
+
+    return retVal;
+}
+
 std::optional<OrderData> WSStreamManager::readOrderData(const Order &order) {
-    int numTries = 0;
-    int maxNumTries = static_cast<int>(m_p->m_timeout / 0.01);
-
-    while (numTries <= maxNumTries) {
-        m_p->m_ordersLocker.lock();
-        std::vector<OrderData>::iterator it;
-
-        for (it = m_p->m_ordersData.begin(); it != m_p->m_ordersData.end(); it++) {
-            if ((*it).m_id == order.m_id || (*it).m_id == std::stoll(order.m_clientId)) {
-                OrderData orderData = *it;
-                m_p->m_ordersData.erase(it);
-                m_p->m_ordersLocker.unlock();
-                return orderData;
-            }
+
+    std::optional<OrderData> retVal;
+    std::unique_lock<std::mutex> lk(m_p->m_ordersLocker);
+
+    m_p->m_ordersCondition.wait_for(lk, std::chrono::seconds(m_p->m_timeout), [&] {
+        retVal = m_p->m_orderStore.take(order);
+        return retVal || m_p->m_timeout == 0;
+    });
+
+    return retVal;
+}
+
+std::optional<OrderData> WSStreamManager::readClosedOrderData(const Order &order, std::chrono::milliseconds timeout,
+                                                              bool stopWhenResting) {
+
+    std::optional<OrderData> retVal;
+    std::unique_lock<std::mutex> lk(m_p->m_ordersLocker);
+    const auto streamErrors = m_p->m_ordersStreamErrors;
+
+    m_p->m_ordersCondition.wait_for(lk, timeout, [&] {
+        if (m_p->m_ordersStreamErrors != streamErrors) {
+            return true;
         }
 
-        m_p->m_ordersLocker.unlock();
-        numTries++;
-        std::this_thread::sleep_for(3ms);
-    }
+        retVal = m_p->m_orderStore.takeClosed(order);
 
-    return {};
+        if (!retVal && stopWhenResting) {
+            retVal = m_p->m_orderStore.takeResting(order);
+        }
+
+        return retVal || m_p->m_disconnectedAt != 0 || m_p->m_timeout == 0;
+    });
+
+    return retVal;
 }
 }
\ No newline at end of file
@@ -8,32 +8,25 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 */
 
 #include <ftx_api/utils.h>
+#include <charconv>
 
 namespace ftx {
 
 static const int SECONDS_PER_MINUTE = 60;
 static const int SECONDS_PER_HOUR = 3600;
 static const int SECONDS_PER_DAY = 86400;
-static const int DAYS_OF_MONTH[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
 
 double readStringAsDouble(const nlohmann::json &json, const std::string &key, double defaultVal) {
-    nlohmann::json::const_iterator it;
+    const auto it = json.find(key);
 
-    it = json.find(key);
+    if (it != json.end() && it.value().is_string()) {
+        const auto &str = it->get_ref<const std::string &>();
+        double retVal;
 
-    try {
-        if (it != json.end()) {
-            if (!it.value().is_null() && it.value().is_string()) {
-                return std::stod(it->get<std::string>());
-            }
+        if (std::from_chars(str.data(), str.data() + str.size(), retVal).ec == std::errc{}) {
+            return retVal;
         }
     }
-    catch (std::invalid_argument &e) {
-
-    }
-    catch (std::out_of_range &e) {
-
-    }
 
     return 0.0;
 }
@@ -88,38 +81,142 @@ std::vector<std::string> splitString(const std::string &s, char delim) {
     return elems;
 }
 
-inline bool isLeapYear(short year) {
-    if (year % 4 != 0) return false;
-    if (year % 100 != 0) return true;
-    return (year % 400) == 0;
+static bool readDigits(std::string_view s, std::size_t pos, std::size_t count, unsigned &value) {
+    value = 0;
+
+    for (std::size_t i = pos; i < pos + count; ++i) {
+        const auto digit = static_cast<unsigned>(s[i] - '0');
+
+        if (digit > 9) {
+            return false;
+        }
+
+        value = value * 10 + digit;
+    }
+
+    return true;
 }
 
-time_t mkgmtime(const struct tm *ptm) {
-    time_t secs = 0;
-    // tm_year is years since 1900
-    int year = ptm->tm_year + 1900;
-    for (int y = 1970; y < year; ++y) {
-        secs += (isLeapYear(y) ? 366 : 365) * SECONDS_PER_DAY;
+bool parseTimestamp(std::string_view timeString, std::int64_t &microseconds) {
+    /// YYYY-MM-DDTHH:MM:SS
+    static const std::size_t FIXED_LENGTH = 19;
+    unsigned year, month, day, hour, min, sec;
+    const auto &s = timeString;
+
+    if (s.size() < FIXED_LENGTH || s[4] != '-' || s[7] != '-' || (s[10] != 'T' && s[10] != ' ') || s[13] != ':' ||
+        s[16] != ':' || !readDigits(s, 0, 4, year) || !readDigits(s, 5, 2, month) || !readDigits(s, 8, 2, day) ||
+        !readDigits(s, 11, 2, hour) || !readDigits(s, 14, 2, min) || !readDigits(s, 17, 2, sec) || month < 1 ||
+        month > 12 || day < 1 || day > 31 || hour > 23 || min > 59 || sec > 60) {
+        return false;
     }
-    // tm_mon is month from 0..11
-    for (int m = 0; m < ptm->tm_mon; ++m) {
-        secs += DAYS_OF_MONTH[m] * SECONDS_PER_DAY;
-        if (m == 1 && isLeapYear(static_cast<short>(year))) {
-            secs += SECONDS_PER_DAY;
+
+    std::size_t pos = FIXED_LENGTH;
+    std::int64_t fraction = 0;
+
+    if (pos < s.size() && s[pos] == '.') {
+        std::int64_t scale = MICROSECONDS_PER_SECOND;
+
+        while (++pos < s.size() && s[pos] >= '0' && s[pos] <= '9') {
+            /// Digits beyond microseconds are truncated
+            if (scale > 1) {
+                scale /= 10;
+                fraction += (s[pos] - '0') * scale;
+            }
+        }
+    }
+
+    std::int64_t offset = 0;
+
+    if (pos < s.size()) {
+        unsigned offsetHour, offsetMin;
+
+        if (s[pos] == 'Z' && pos + 1 == s.size()) {
+            offset = 0;
+        } else if ((s[pos] == '+' || s[pos] == '-') && pos + 6 == s.size() && s[pos + 3] == ':' &&
+                   readDigits(s, pos + 1, 2, offsetHour) && readDigits(s, pos + 4, 2, offsetMin)) {
+            offset = static_cast<std::int64_t>(offsetHour * SECONDS_PER_HOUR + offsetMin * SECONDS_PER_MINUTE);
+
+            if (s[pos] == '-') {
+                offset = -offset;
+            }
+        } else {
+            return false;
         }
     }
-    secs += (ptm->tm_mday - 1) * SECONDS_PER_DAY;
-    secs += ptm->tm_hour * SECONDS_PER_HOUR;
-    secs += ptm->tm_min * SECONDS_PER_MINUTE;
-    secs += ptm->tm_sec;
 
-    return secs;
+    const std::int64_t secs = daysFromCivil(year, month, day) * SECONDS_PER_DAY + hour * SECONDS_PER_HOUR +
+                              min * SECONDS_PER_MINUTE + sec - offset;
+    microseconds = secs * MICROSECONDS_PER_SECOND + fraction;
+    return true;
+}
+
+time_t mkgmtime(const struct tm *ptm) {
+    /// tm_mon may be out of its 0..11 range as in std::mktime
+    std::int64_t year = ptm->tm_year + 1900 + ptm->tm_mon / 12;
+    int month = ptm->tm_mon % 12;
+
+    if (month < 0) {
+        month += 12;
+        year--;
+    }
+
+    const std::int64_t days = daysFromCivil(year, month + 1, 1) + ptm->tm_mday - 1;
+    return static_cast<time_t>(days * SECONDS_PER_DAY + ptm->tm_hour * SECONDS_PER_HOUR +
+                               ptm->tm_min * SECONDS_PER_MINUTE + ptm->tm_sec);
 }
 
 int64_t getTimeStampFromString(const std::string &timeString, const std::string &format) {
+
+    if (std::int64_t microseconds; parseTimestamp(timeString, microseconds)) {
+        return microseconds / MICROSECONDS_PER_SECOND;
+    }
+
     std::tm time{};
     std::istringstream ss(timeString);
     ss >> std::get_time(&time, format.c_str());
     return mkgmtime(&time);
 }
-}
\ No newline at end of file
+
+std::string getStringFromTimeStamp(std::int64_t timeStamp) {
+    std::int64_t days = timeStamp / SECONDS_PER_DAY;
+    std::int64_t secs = timeStamp % SECONDS_PER_DAY;
+
+    if (secs < 0) {
+        secs += SECONDS_PER_DAY;
+        days--;
+    }
+
+    /// Civil date from days since epoch - http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+    days += 719468;
+    const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const auto doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+    const std::int64_t year = static_cast<std::int64_t>(yoe) + era * 400 + (month <= 2);
+
+    return std::format("{:04}-{:02}-{:02}T{:02}:{:02}:{:02}+00:00", year, month, day, secs / SECONDS_PER_HOUR,
+                       (secs % SECONDS_PER_HOUR) / SECONDS_PER_MINUTE, secs % SECONDS_PER_MINUTE);
+}
+
+std::string getStringFromMicroseconds(std::int64_t microseconds) {
+    std::int64_t secs = microseconds / MICROSECONDS_PER_SECOND;
+    std::int64_t fraction = microseconds % MICROSECONDS_PER_SECOND;
+
+    if (fraction < 0) {
+        fraction += MICROSECONDS_PER_SECOND;
+        secs--;
+    }
+
+    auto retVal = getStringFromTimeStamp(secs);
+
+    if (fraction != 0) {
+        /// Insert before the "+00:00" suffix
+        retVal.insert(retVal.size() - 6, std::format(".{:06}", fraction));
+    }
+
+    return retVal;
+}
+}